@@ -0,0 +1,283 @@
+#ifndef ACCUMULATION_BUFFER_HPP
+#define ACCUMULATION_BUFFER_HPP
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+
+#include "Global.hpp"
+
+/* AccumulationBuffer
+ * Two RGBA32F textures used as ping-pong render targets.
+ * The path tracer reads the previous texture and writes previous + new samples into the other one:
+ *     rgb: sum of radiance of all samples
+ *     a  : number of samples
+ * so a pixel's estimate is rgb / a and nothing has to leave the GPU until the image is saved.
+ * A second R32F attachment keeps the primary hit distance of every pixel for reprojection after a camera change
+ * (written by SimplePathTracing.fs only, the wavefront backend doesn't reproject).
+ * A third R32F attachment sums the squared luminance of every sample, with rgb and a it gives the variance of
+ * a pixel's estimate for adaptive sampling (IsConverged() in PathTracingCommon.glsl).
+ * Two RGBA32F feature textures hold the first hit's albedo and normal / hit distance for the Denoiser. They don't
+ * depend on the sample (FirstHitFeatures() in PathTracingCommon.glsl), so both framebuffers share them.
+ * With AOVs a sixth RGBA32F attachment accumulates the direct lighting like the first one, see AovBuffer.
+ */
+class AccumulationBuffer
+{
+private:
+    unsigned int framebufferID[2];
+    unsigned int textureID[2];
+    unsigned int depthTextureID[2];
+    unsigned int momentTextureID[2];
+    unsigned int albedoTextureID;
+    unsigned int normalTextureID;
+    unsigned int directTextureID[2];   // 0 without AOVs
+
+    int current;       // index of the texture holding the latest accumulation
+    int sampleCount;   // samples per pixel accumulated so far
+
+public:
+    AccumulationBuffer() : directTextureID{0, 0}, current(0), sampleCount(0) {}
+    ~AccumulationBuffer() {}
+
+    void GenerateBuffer(bool aovs = false);
+
+    void Bind(int width = Global::WindowWidth, int height = Global::WindowHeight);
+    void Swap(int samples);
+    void Reset();
+
+    void UseTexture();
+    void UseDepthTexture();
+    void UseMomentTexture();
+    void UseFeatureTextures();
+    void UseDirectTexture();
+    void BindImage(unsigned int unit);
+    void BindMomentImage(unsigned int unit);
+    void BindFeatureImages(unsigned int unit);
+    void BindDirectImage(unsigned int unit);
+
+    void BindReadBuffer();
+
+    void ReadBack(std::vector<float> &pixels, std::vector<float> &moments);
+    void ReadBackFeatures(std::vector<float> &albedo, std::vector<float> &normals);
+    void ReadBackDirect(std::vector<float> &direct);
+    void Restore(const std::vector<float> &pixels, const std::vector<float> &moments, int samples);
+
+    int GetSampleCount() const { return sampleCount; }
+    bool HasAovs() const { return directTextureID[0] != 0; }
+};
+
+// aovs: also accumulate the direct lighting, the shaders' RenderAOVs has to match.
+void AccumulationBuffer::GenerateBuffer(bool aovs)
+{
+    glGenTextures(2, textureID);
+    glGenTextures(2, depthTextureID);
+    glGenTextures(2, momentTextureID);
+    glGenTextures(1, &albedoTextureID);
+    glGenTextures(1, &normalTextureID);
+    glGenFramebuffers(2, framebufferID);
+    if (aovs)
+        glGenTextures(2, directTextureID);
+
+    const unsigned int featureTextureID[2] = { albedoTextureID, normalTextureID };
+    for (int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, featureTextureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+        // linear for the display pass' upsampling of reduced resolutions, path tracing reads with texelFetch.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_2D, depthTextureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_2D, momentTextureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, depthTextureID[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, momentTextureID[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, albedoTextureID, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, normalTextureID, 0);
+
+        if (aovs)
+        {
+            glBindTexture(GL_TEXTURE_2D, directTextureID[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT5, GL_TEXTURE_2D, directTextureID[i], 0);
+        }
+
+        // without AOVs the sixth output of SimplePathTracing.fs has no attachment and is dropped.
+        const GLenum drawBuffers[6] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2,
+                                        GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5 };
+        glDrawBuffers(aovs ? 6 : 5, drawBuffers);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::ACCUMULATION_BUFFER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Render target of the next pass, the previous accumulation stays readable through UseTexture().
+// A reduced resolution renders into the lower left width x height texels.
+void AccumulationBuffer::Bind(int width, int height)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[1 - current]);
+    glViewport(0, 0, width, height);
+}
+
+void AccumulationBuffer::Swap(int samples)
+{
+    current = 1 - current;
+    sampleCount += samples;
+}
+
+// The shader ignores the previous texture while sampleCount is 0, so no clear is needed.
+void AccumulationBuffer::Reset()
+{
+    sampleCount = 0;
+}
+
+void AccumulationBuffer::UseTexture()
+{
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, textureID[current]);
+}
+
+void AccumulationBuffer::UseDepthTexture()
+{
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, depthTextureID[current]);
+}
+
+void AccumulationBuffer::UseMomentTexture()
+{
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, momentTextureID[current]);
+}
+
+// Albedo to texture unit 6, normal and hit distance to unit 7, read by the Denoiser.
+void AccumulationBuffer::UseFeatureTextures()
+{
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_2D, albedoTextureID);
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_2D, normalTextureID);
+}
+
+// Direct lighting of the latest accumulation to texture unit 9, nothing without AOVs (reads as zero).
+void AccumulationBuffer::UseDirectTexture()
+{
+    glActiveTexture(GL_TEXTURE9);
+    glBindTexture(GL_TEXTURE_2D, directTextureID[current]);
+}
+
+// Render target of the next pass as a writable image, used by the wavefront backend instead of Bind().
+void AccumulationBuffer::BindImage(unsigned int unit)
+{
+    glBindImageTexture(unit, textureID[1 - current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+}
+
+void AccumulationBuffer::BindMomentImage(unsigned int unit)
+{
+    glBindImageTexture(unit, momentTextureID[1 - current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+}
+
+// Albedo to image unit, normal and hit distance to unit + 1, written by WavefrontShade.cs.
+void AccumulationBuffer::BindFeatureImages(unsigned int unit)
+{
+    glBindImageTexture(unit, albedoTextureID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glBindImageTexture(unit + 1, normalTextureID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+}
+
+// Direct lighting target of the next pass, written by WavefrontAccumulate.cs.
+void AccumulationBuffer::BindDirectImage(unsigned int unit)
+{
+    glBindImageTexture(unit, directTextureID[1 - current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+}
+
+// Read framebuffer of the latest accumulation, FrameSaver::RequestReadback() reads from it.
+void AccumulationBuffer::BindReadBuffer()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebufferID[current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+}
+
+// Latest accumulation (rgba) and moments, bottom row first, e.g. for a Checkpoint.
+void AccumulationBuffer::ReadBack(std::vector<float> &pixels, std::vector<float> &moments)
+{
+    pixels.resize(4 * Global::PixelCount);
+    moments.resize(Global::PixelCount);
+
+    glBindTexture(GL_TEXTURE_2D, textureID[current]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, momentTextureID[current]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, moments.data());
+}
+
+// Features of the last pass (rgba each), bottom row first, e.g. for Denoiser::RunCpu().
+void AccumulationBuffer::ReadBackFeatures(std::vector<float> &albedo, std::vector<float> &normals)
+{
+    albedo.resize(4 * Global::PixelCount);
+    normals.resize(4 * Global::PixelCount);
+
+    glBindTexture(GL_TEXTURE_2D, albedoTextureID);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, albedo.data());
+    glBindTexture(GL_TEXTURE_2D, normalTextureID);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, normals.data());
+}
+
+// Direct lighting of the latest accumulation (rgb: sum, a: samples), bottom row first, for AovBuffer.
+void AccumulationBuffer::ReadBackDirect(std::vector<float> &direct)
+{
+    direct.resize(4 * Global::PixelCount);
+
+    glBindTexture(GL_TEXTURE_2D, directTextureID[current]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, direct.data());
+}
+
+// Replaces the latest accumulation with one of ReadBack(), the next pass continues from it.
+// The hit distances and features aren't restored, only a camera change reprojects with the former and the next pass
+// writes the latter again.
+void AccumulationBuffer::Restore(const std::vector<float> &pixels, const std::vector<float> &moments, int samples)
+{
+    glBindTexture(GL_TEXTURE_2D, textureID[current]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, Global::WindowWidth, Global::WindowHeight, GL_RGBA, GL_FLOAT, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, momentTextureID[current]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, Global::WindowWidth, Global::WindowHeight, GL_RED, GL_FLOAT, moments.data());
+
+    sampleCount = samples;
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef AOV_BUFFER_HPP
+#define AOV_BUFFER_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+
+/* AovBuffer
+ * Arbitrary output variables of a render, read back from the AccumulationBuffer into float buffers on the CPU and
+ * written next to the beauty image for compositing and external denoisers. They come from the same trace:
+ *     beauty   : average radiance, the saved image before tone mapping
+ *     albedo   : diffuse color of the first hit, 1 on lights and misses
+ *     normal   : shading normal of the first hit, facing the camera
+ *     depth    : distance of the first hit along the camera ray, 1e30 where nothing was hit
+ *     material : material key of the first hit (hash of its name, see ModelData), -1 where nothing was hit
+ *     direct   : emission seen by the camera and light reaching the first hit directly
+ *     indirect : everything else, beauty - direct
+ * The first hit goes through the pixel center (FirstHitFeatures() in PathTracingCommon.glsl), so the first hit AOVs
+ * are exact and unfiltered. direct is accumulated per sample like the beauty, only with Global::RenderAOVs or --aovs.
+ * Write() saves <base>_<aov>.pfm: linear floats, rgb (PF) or one channel (Pf), bottom row first as read back.
+ */
+class AovBuffer
+{
+private:
+    std::vector<float> beauty;     // rgb
+    std::vector<float> albedo;     // rgb
+    std::vector<float> normal;     // xyz
+    std::vector<float> depth;
+    std::vector<float> material;
+    std::vector<float> direct;     // rgb
+    std::vector<float> indirect;   // rgb
+
+    static bool WritePfm(const std::string &fileName, const std::vector<float> &data, int channels);
+
+public:
+    AovBuffer() {}
+    ~AovBuffer() {}
+
+    void ReadBack(AccumulationBuffer &accumulation);
+    bool Write(const std::string &baseName) const;
+};
+
+// The accumulation has to be generated with AOVs and hold at least one sample.
+void AovBuffer::ReadBack(AccumulationBuffer &accumulation)
+{
+    std::vector<float> pixels;
+    std::vector<float> moments;
+    std::vector<float> albedoFeature;
+    std::vector<float> normalFeature;
+    std::vector<float> directSum;
+
+    accumulation.ReadBack(pixels, moments);
+    accumulation.ReadBackFeatures(albedoFeature, normalFeature);
+    accumulation.ReadBackDirect(directSum);
+
+    beauty.resize(3 * Global::PixelCount);
+    albedo.resize(3 * Global::PixelCount);
+    normal.resize(3 * Global::PixelCount);
+    depth.resize(Global::PixelCount);
+    material.resize(Global::PixelCount);
+    direct.resize(3 * Global::PixelCount);
+    indirect.resize(3 * Global::PixelCount);
+
+    for (unsigned int i = 0; i < Global::PixelCount; i++)
+    {
+        // rgb / a of both sums, unrendered pixels stay black.
+        float samples = std::max(pixels[4 * i + 3], 1.0f);
+        float directSamples = std::max(directSum[4 * i + 3], 1.0f);
+
+        for (int c = 0; c < 3; c++)
+        {
+            beauty[3 * i + c] = pixels[4 * i + c] / samples;
+            albedo[3 * i + c] = albedoFeature[4 * i + c];
+            normal[3 * i + c] = normalFeature[4 * i + c];
+            direct[3 * i + c] = directSum[4 * i + c] / directSamples;
+            indirect[3 * i + c] = beauty[3 * i + c] - direct[3 * i + c];
+        }
+
+        depth[i] = normalFeature[4 * i + 3];
+        material[i] = albedoFeature[4 * i + 3];
+    }
+}
+
+bool AovBuffer::Write(const std::string &baseName) const
+{
+    return WritePfm(baseName + "_beauty.pfm", beauty, 3) &&
+           WritePfm(baseName + "_albedo.pfm", albedo, 3) &&
+           WritePfm(baseName + "_normal.pfm", normal, 3) &&
+           WritePfm(baseName + "_depth.pfm", depth, 1) &&
+           WritePfm(baseName + "_material.pfm", material, 1) &&
+           WritePfm(baseName + "_direct.pfm", direct, 3) &&
+           WritePfm(baseName + "_indirect.pfm", indirect, 3);
+}
+
+// Portable float map, a negative scale marks little endian data.
+bool AovBuffer::WritePfm(const std::string &fileName, const std::vector<float> &data, int channels)
+{
+    std::ofstream stream(fileName, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "ERROR::AOV_BUFFER::FILE_NOT_SUCCESSFULLY_OPENED " << fileName << std::endl;
+        return false;
+    }
+
+    stream << (channels == 3 ? "PF" : "Pf") << "\n" << Global::WindowWidth << " " << Global::WindowHeight << "\n-1.0\n";
+    stream.write((const char *)data.data(), data.size() * sizeof(float));
+
+    if (!stream)
+    {
+        std::cout << "ERROR::AOV_BUFFER::FILE_NOT_SUCCESSFULLY_WRITTEN " << fileName << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef BATCH_RENDERER_HPP
+#define BATCH_RENDERER_HPP
+
+#include <glad/glad.h>
+
+#include <stbi/stb_image_write.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "Options.hpp"
+
+// Settings the samples of a headless render depend on, compared before render state is shared between processes
+// (Checkpoint, TileCoordinator). stratification: SampleCount of the path tracing shaders, see main.cpp.
+struct RenderSettings
+{
+    int width;
+    int height;
+    int backend;
+    int sampler;
+    int maxDepth;
+    int stratification;
+    int adaptiveSampling;
+    int passSamples;
+
+    static RenderSettings Current(int stratification)
+    {
+        return { (int)Global::WindowWidth, (int)Global::WindowHeight, Global::Backend, Global::Sampler, Global::MaxDepth,
+                 stratification, Global::AdaptiveSampling, Global::BatchPassSamples };
+    }
+
+    bool operator==(const RenderSettings &other) const { return std::memcmp(this, &other, sizeof(RenderSettings)) == 0; }
+};
+
+/* BatchRenderer
+ * Non-interactive render of the headless mode: passes until the first of the Options limits is reached
+ * (samples per pixel, seconds, relative noise), with a progress line and an ETA every Global::BatchProgressInterval.
+ * Noise is estimated without a reference: the accumulation is read back whenever its sample count doubled,
+ * for nested estimates of M and N > M samples the difference has variance sigma^2 (1 / M - 1 / N), so
+ *     noise(N) = rms(L(N) - L(M)) / sqrt(N / M - 1) / mean(L(N))
+ * with L the luminance of the average of each pixel. The noise falls with 1 / sqrt(N), which gives its ETA.
+ * With adaptive sampling converged pixels stop receiving samples, GetMeanSamples() is what was actually traced.
+ * The caller saves the image, WriteStats() writes the statistics as JSON, WriteSampleMap() the samples per pixel.
+ * WriteState() and ReadState() carry the progress (passes, time, noise estimate) through a Checkpoint.
+ */
+class BatchRenderer
+{
+private:
+    enum StopReason { STOP_SAMPLES, STOP_TIME, STOP_NOISE };
+    static constexpr const char *StopReasonString[] = { "samples", "time", "noise" };
+
+    const Options &options;
+    AccumulationBuffer &accumulation;
+
+    int passCount;
+    double renderTime;     // seconds
+    double noise;          // < 0 until two estimates were compared
+    double meanSamples;    // per pixel, of the final accumulation
+    StopReason reason;
+
+    std::vector<float> pixels;          // readback of the accumulation, rgba
+    std::vector<float> lastLuminance;   // average luminance of every pixel at lastSamples
+    int lastSamples;
+
+    void ReadAccumulation();
+    void EstimateNoise();
+    void PrintProgress(bool isFinal) const;
+    double GetEta() const;
+
+public:
+    BatchRenderer(const Options &options, AccumulationBuffer &accumulation);
+    ~BatchRenderer() {}
+
+    // renderPass: renders at most maxSamples samples per pixel, returns the samples of a completed pass or 0.
+    // checkpoint: called every Global::CheckpointInterval seconds after a completed pass and once the render stops.
+    void Run(const std::function<int(int maxSamples)> &renderPass, const std::function<void()> &checkpoint = nullptr);
+
+    void WriteState(std::ostream &stream) const;
+    bool ReadState(std::istream &stream);
+
+    void WriteStats(double saveTime) const;
+    void WriteSampleMap() const;
+
+    int    GetPassCount() const { return passCount; }
+    double GetRenderTime() const { return renderTime; }
+    double GetNoise() const { return noise; }
+    double GetMeanSamples() const { return meanSamples; }
+};
+
+BatchRenderer::BatchRenderer(const Options &options, AccumulationBuffer &accumulation)
+    : options(options),
+      accumulation(accumulation),
+      passCount(0),
+      renderTime(0.0),
+      noise(-1.0),
+      meanSamples(0.0),
+      reason(STOP_SAMPLES),
+      lastSamples(0)
+{
+}
+
+void BatchRenderer::Run(const std::function<int(int maxSamples)> &renderPass, const std::function<void()> &checkpoint)
+{
+    const int unlimited = 1 << 30;
+    int targetSamples = options.samples > 0 ? options.samples : unlimited;
+
+    // a resumed render continues the clock of its checkpoint.
+    auto start = std::chrono::steady_clock::now() -
+                 std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(renderTime));
+    double lastProgress = renderTime;
+    double lastCheckpoint = renderTime;
+
+    while (true)
+    {
+        int samples = accumulation.GetSampleCount();
+
+        if (samples >= targetSamples)
+        {
+            reason = STOP_SAMPLES;
+            break;
+        }
+        if (options.timeBudget > 0.0f && renderTime >= options.timeBudget)
+        {
+            reason = STOP_TIME;
+            break;
+        }
+        if (options.noiseThreshold > 0.0f && noise >= 0.0 && noise <= options.noiseThreshold)
+        {
+            reason = STOP_NOISE;
+            break;
+        }
+
+        bool isPassComplete = renderPass(targetSamples - samples) > 0;
+        if (isPassComplete)
+        {
+            passCount++;
+
+            if (options.noiseThreshold > 0.0f && accumulation.GetSampleCount() >= 2 * lastSamples)
+                EstimateNoise();
+        }
+
+        // without a finished GPU the clock would only measure how fast commands are queued.
+        glFinish();
+        renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (renderTime - lastProgress >= Global::BatchProgressInterval)
+        {
+            PrintProgress(false);
+            lastProgress = renderTime;
+        }
+
+        if (checkpoint && isPassComplete && renderTime - lastCheckpoint >= Global::CheckpointInterval)
+        {
+            checkpoint();
+            lastCheckpoint = renderTime;
+        }
+    }
+
+    if (checkpoint)
+        checkpoint();
+
+    ReadAccumulation();
+    meanSamples = 0.0;
+    for (unsigned int i = 0; i < Global::PixelCount; i++)
+        meanSamples += pixels[4 * i + 3];
+    meanSamples /= Global::PixelCount;
+
+    PrintProgress(true);
+}
+
+void BatchRenderer::ReadAccumulation()
+{
+    pixels.resize(4 * Global::PixelCount);
+    accumulation.BindReadBuffer();
+    glReadPixels(0, 0, Global::WindowWidth, Global::WindowHeight, GL_RGBA, GL_FLOAT, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+// Compares the accumulation with the one of the last estimate, see the class comment.
+void BatchRenderer::EstimateNoise()
+{
+    ReadAccumulation();
+
+    int samples = accumulation.GetSampleCount();
+    std::vector<float> luminance(Global::PixelCount);
+
+    for (unsigned int i = 0; i < Global::PixelCount; i++)
+    {
+        float count = std::max(pixels[4 * i + 3], 1.0f);
+        luminance[i] = (0.2126f * pixels[4 * i] + 0.7152f * pixels[4 * i + 1] + 0.0722f * pixels[4 * i + 2]) / count;
+    }
+
+    if (lastSamples > 0)
+    {
+        double squares = 0.0;
+        double mean = 0.0;
+
+        for (unsigned int i = 0; i < Global::PixelCount; i++)
+        {
+            double difference = luminance[i] - lastLuminance[i];
+            squares += difference * difference;
+            mean += luminance[i];
+        }
+
+        mean /= Global::PixelCount;
+        double rms = std::sqrt(squares / Global::PixelCount / ((double)samples / lastSamples - 1.0));
+        noise = mean > 0.0 ? rms / mean : 0.0;
+    }
+
+    lastLuminance.swap(luminance);
+    lastSamples = samples;
+}
+
+// Progress of Run(), binary, see Checkpoint.
+void BatchRenderer::WriteState(std::ostream &stream) const
+{
+    stream.write((const char *)&passCount, sizeof(passCount));
+    stream.write((const char *)&renderTime, sizeof(renderTime));
+    stream.write((const char *)&noise, sizeof(noise));
+    stream.write((const char *)&lastSamples, sizeof(lastSamples));
+
+    if (lastSamples > 0)
+        stream.write((const char *)lastLuminance.data(), Global::PixelCount * sizeof(float));
+}
+
+bool BatchRenderer::ReadState(std::istream &stream)
+{
+    stream.read((char *)&passCount, sizeof(passCount));
+    stream.read((char *)&renderTime, sizeof(renderTime));
+    stream.read((char *)&noise, sizeof(noise));
+    stream.read((char *)&lastSamples, sizeof(lastSamples));
+
+    lastLuminance.resize(lastSamples > 0 ? Global::PixelCount : 0);
+    if (lastSamples > 0)
+        stream.read((char *)lastLuminance.data(), Global::PixelCount * sizeof(float));
+
+    return (bool)stream;
+}
+
+// Seconds until the first limit is reached, < 0 if unknown.
+double BatchRenderer::GetEta() const
+{
+    int samples = accumulation.GetSampleCount();
+    if (samples == 0)
+        return -1.0;
+
+    double perSample = renderTime / samples;
+    double eta = -1.0;
+
+    auto consider = [&eta](double seconds) { eta = eta < 0.0 ? seconds : std::min(eta, seconds); };
+
+    if (options.samples > 0)
+        consider(perSample * std::max(0, options.samples - samples));
+    if (options.timeBudget > 0.0f)
+        consider(std::max(0.0, options.timeBudget - renderTime));
+    if (options.noiseThreshold > 0.0f && noise > 0.0)
+    {
+        // noise was estimated at lastSamples.
+        double needed = lastSamples * (noise / options.noiseThreshold) * (noise / options.noiseThreshold);
+        consider(perSample * std::max(0.0, needed - samples));
+    }
+
+    return eta;
+}
+
+void BatchRenderer::PrintProgress(bool isFinal) const
+{
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1) << accumulation.GetSampleCount() << " spp";
+    if (options.samples > 0)
+        line << " / " << options.samples;
+    line << ", " << renderTime << " s";
+    if (noise >= 0.0)
+        line << ", noise " << std::setprecision(4) << noise << std::setprecision(1);
+
+    if (isFinal)
+    {
+        if (Global::AdaptiveSampling)
+            line << ", mean " << meanSamples << " spp";
+        std::cout << "\rRendered " << line.str() << ", " << passCount << " passes, stopped by " << StopReasonString[reason] << "." << std::endl;
+        return;
+    }
+
+    double eta = GetEta();
+    if (eta >= 0.0)
+        line << ", ETA " << eta << " s";
+
+    std::cout << "\rRendering " << line.str() << "    " << std::flush;
+}
+
+// Statistics of the finished render to Options::stats, saveTime in ms.
+void BatchRenderer::WriteStats(double saveTime) const
+{
+    std::ofstream json(options.stats);
+    if (!json)
+    {
+        std::cout << "ERROR::BATCH_RENDERER::FILE_NOT_SUCCESSFULLY_OPENED " << options.stats << std::endl;
+        return;
+    }
+
+    int samples = accumulation.GetSampleCount();
+    double samplesPerSecond = renderTime > 0.0 ? (double)Global::PixelCount * samples / renderTime : 0.0;
+
+    json << "{\n"
+         << "    \"output\": \"" << options.output << "\",\n"
+         << "    \"width\": " << Global::WindowWidth << ",\n"
+         << "    \"height\": " << Global::WindowHeight << ",\n"
+         << "    \"backend\": \"" << (Global::Backend == Global::WAVEFRONT ? "wavefront" : "fragment") << "\",\n"
+         << "    \"sampler\": \"" << Global::SamplerString[Global::Sampler] << "\",\n"
+         << "    \"max_depth\": " << Global::MaxDepth << ",\n"
+         << "    \"spp\": " << samples << ",\n"
+         << "    \"adaptive_sampling\": " << (Global::AdaptiveSampling ? "true" : "false") << ",\n"
+         << "    \"mean_spp\": " << meanSamples << ",\n"
+         << "    \"passes\": " << passCount << ",\n"
+         << "    \"render_seconds\": " << renderTime << ",\n"
+         << "    \"save_ms\": " << saveTime << ",\n"
+         << "    \"ms_per_spp\": " << (samples > 0 ? 1000.0 * renderTime / samples : 0.0) << ",\n"
+         << "    \"msamples_per_second\": " << samplesPerSecond / 1.0e6 << ",\n";
+
+    if (noise >= 0.0)
+        json << "    \"noise\": " << noise << ",\n";
+    else
+        json << "    \"noise\": null,\n";
+
+    json << "    \"stopped_by\": \"" << StopReasonString[reason] << "\"\n"
+         << "}\n";
+}
+
+// Samples of every pixel relative to the most any pixel received to Options::sampleMap, top row first.
+void BatchRenderer::WriteSampleMap() const
+{
+    float maxSamples = 1.0f;
+    for (unsigned int i = 0; i < Global::PixelCount; i++)
+        maxSamples = std::max(maxSamples, pixels[4 * i + 3]);
+
+    std::vector<unsigned char> gray(Global::PixelCount);
+    for (unsigned int y = 0; y < Global::WindowHeight; y++)
+        for (unsigned int x = 0; x < Global::WindowWidth; x++)
+        {
+            float samples = pixels[4 * ((Global::WindowHeight - 1 - y) * Global::WindowWidth + x) + 3];
+            gray[y * Global::WindowWidth + x] = (unsigned char)(255.0f * samples / maxSamples + 0.5f);
+        }
+
+    if (!stbi_write_png(options.sampleMap.c_str(), Global::WindowWidth, Global::WindowHeight, 1, gray.data(), Global::WindowWidth))
+        std::cout << "ERROR::BATCH_RENDERER::FILE_NOT_SUCCESSFULLY_WRITTEN " << options.sampleMap << std::endl;
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Global.hpp"
+#include "shader.hpp"
+
+/* ConvergenceBenchmark
+ * Renders the scene with every sampler into a float framebuffer and reports the RMSE
+ * against a high spp reference at spp = 1, 2, 4, ..., Global::BenchmarkMaxSpp.
+ * The reference uses the independent sampler with frame indices disjoint from the measured runs.
+ * Results are printed and written to Global::BenchmarkPath as csv (sampler, spp, rmse).
+ */
+class ConvergenceBenchmark
+{
+private:
+    Shader &shader;
+
+    unsigned int framebufferID;
+    unsigned int textureID;
+
+    std::vector<float>  frameBuffer;
+    std::vector<double> reference;
+    std::vector<double> accumulation;
+
+    void GenerateFramebuffer();
+
+    void RenderFrame(const std::function<void()> &draw, int frameIndex);
+    void Accumulate(std::vector<double> &buffer);
+    double RMSE(const std::vector<double> &buffer, int spp) const;
+
+public:
+    ConvergenceBenchmark(Shader &shader);
+    ~ConvergenceBenchmark();
+
+    void Run(const std::function<void()> &draw);
+};
+
+ConvergenceBenchmark::ConvergenceBenchmark(Shader &shader) : shader(shader), framebufferID(0), textureID(0)
+{
+    frameBuffer.resize(3 * Global::PixelCount);
+    reference.resize(3 * Global::PixelCount);
+    accumulation.resize(3 * Global::PixelCount);
+}
+
+ConvergenceBenchmark::~ConvergenceBenchmark()
+{
+    glDeleteFramebuffers(1, &framebufferID);
+    glDeleteTextures(1, &textureID);
+}
+
+void ConvergenceBenchmark::GenerateFramebuffer()
+{
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &framebufferID);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::BENCHMARK::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+}
+
+void ConvergenceBenchmark::RenderFrame(const std::function<void()> &draw, int frameIndex)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+    glViewport(0, 0, Global::WindowWidth, Global::WindowHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    shader.use();
+    shader.setInt("FirstSample", frameIndex);
+    shader.setInt("AccumulatedSamples", 0);
+    draw();
+
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, Global::WindowWidth, Global::WindowHeight, GL_RGB, GL_FLOAT, frameBuffer.data());
+}
+
+void ConvergenceBenchmark::Accumulate(std::vector<double> &buffer)
+{
+    for (unsigned int i = 0; i < 3 * Global::PixelCount; i++)
+        buffer[i] += frameBuffer[i];
+}
+
+double ConvergenceBenchmark::RMSE(const std::vector<double> &buffer, int spp) const
+{
+    double sum = 0.0;
+    for (unsigned int i = 0; i < 3 * Global::PixelCount; i++)
+    {
+        double diff = buffer[i] / spp - reference[i] / Global::BenchmarkReferenceSpp;
+        sum += diff * diff;
+    }
+
+    return std::sqrt(sum / (3 * Global::PixelCount));
+}
+
+void ConvergenceBenchmark::Run(const std::function<void()> &draw)
+{
+    GenerateFramebuffer();
+
+    std::ofstream outStream(Global::BenchmarkPath);
+    outStream << "sampler,spp,rmse" << std::endl;
+
+    shader.use();
+    shader.setInt("SampleCount", Global::BenchmarkMaxSpp);
+
+    // reference
+    shader.setInt("SamplerType", Global::INDEPENDENT);
+    for (int i = 0; i < Global::BenchmarkReferenceSpp; i++)
+    {
+        RenderFrame(draw, Global::BenchmarkMaxSpp + i);
+        Accumulate(reference);
+
+        std::cerr << "Reference: " << std::setw(5) << std::right << i + 1 << " / " << Global::BenchmarkReferenceSpp << "\r";
+        std::cerr.flush();
+    }
+    std::cerr << std::endl;
+
+    for (int sampler = Global::INDEPENDENT; sampler <= Global::BLUE_NOISE; sampler++)
+    {
+        std::fill(accumulation.begin(), accumulation.end(), 0.0);
+
+        shader.use();
+        shader.setInt("SamplerType", sampler);
+
+        for (int spp = 1; spp <= Global::BenchmarkMaxSpp; spp++)
+        {
+            RenderFrame(draw, spp - 1);
+            Accumulate(accumulation);
+
+            if ((spp & (spp - 1)) != 0)
+                continue;
+
+            double rmse = RMSE(accumulation, spp);
+            outStream << Global::SamplerString[sampler] << "," << spp << "," << rmse << std::endl;
+            std::cout << std::setw(12) << std::left << Global::SamplerString[sampler]
+                      << " spp: " << std::setw(5) << std::left << spp << " rmse: " << rmse << std::endl;
+        }
+    }
+
+    outStream.close();
+
+    shader.use();
+    shader.setInt("SampleCount", Global::spp);
+    shader.setInt("SamplerType", Global::Sampler);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef BLUE_NOISE_HPP
+#define BLUE_NOISE_HPP
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Global.hpp"
+
+/* BlueNoise
+ * Generates a tileable blue-noise rank texture with the void-and-cluster algorithm (Ulichney 1993).
+ * Every texel holds a unique value in [0, 1), neighbouring texels are as far apart in value as possible,
+ * so a per-dimension toroidal shift of the tile gives well distributed low spp samples.
+ * The texture is generated once at start up (a 64 * 64 tile takes a fraction of a second).
+ */
+class BlueNoise
+{
+private:
+    const int size;
+    const int pixelCount;
+
+    std::vector<float> energyLUT;   // gaussian energy indexed by toroidal offset
+    std::vector<float> energy;      // accumulated energy of every pixel
+    std::vector<bool>  pattern;     // current binary pattern
+    std::vector<float> noiseData;   // final ranks in [0, 1)
+
+    unsigned int noiseTextureID;
+
+    void GenerateEnergyLUT();
+    void Splat(int index, float sign);
+
+    int TightestCluster();
+    int LargestVoid();
+
+    void GenerateNoiseData();
+
+public:
+    BlueNoise(int size = Global::BlueNoiseSize) : size(size), pixelCount(size * size), noiseTextureID(0) {}
+    ~BlueNoise() {}
+
+    void GenerateNoiseTexture();
+    void UseNoiseTexture();
+
+    const std::vector<float>& GetNoiseData() const { return noiseData; }
+};
+
+void BlueNoise::GenerateEnergyLUT()
+{
+    const float sigma = 1.5f;
+
+    energyLUT.resize(pixelCount);
+
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            int dx = std::min(x, size - x);
+            int dy = std::min(y, size - y);
+            energyLUT[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+        }
+    }
+}
+
+// Add (sign = 1) or remove (sign = -1) the energy of a single point.
+void BlueNoise::Splat(int index, float sign)
+{
+    int px = index % size, py = index / size;
+
+    for (int y = 0; y < size; y++)
+    {
+        int dy = (y - py + size) % size;
+        for (int x = 0; x < size; x++)
+        {
+            int dx = (x - px + size) % size;
+            energy[y * size + x] += sign * energyLUT[dy * size + dx];
+        }
+    }
+}
+
+int BlueNoise::TightestCluster()
+{
+    int result = -1;
+    for (int i = 0; i < pixelCount; i++)
+        if (pattern[i] && (result < 0 || energy[i] > energy[result]))
+            result = i;
+    return result;
+}
+
+int BlueNoise::LargestVoid()
+{
+    int result = -1;
+    for (int i = 0; i < pixelCount; i++)
+        if (!pattern[i] && (result < 0 || energy[i] < energy[result]))
+            result = i;
+    return result;
+}
+
+void BlueNoise::GenerateNoiseData()
+{
+    GenerateEnergyLUT();
+
+    energy.assign(pixelCount, 0.0f);
+    pattern.assign(pixelCount, false);
+    noiseData.assign(pixelCount, 0.0f);
+
+    // 1. initial binary pattern: ~10% random points, relaxed until the tightest cluster is the largest void.
+    std::mt19937 generator(Global::BlueNoiseSeed);
+    std::uniform_int_distribution<int> distribution(0, pixelCount - 1);
+
+    int ones = 0;
+    while (ones < pixelCount / 10)
+    {
+        int index = distribution(generator);
+        if (pattern[index])
+            continue;
+        pattern[index] = true;
+        Splat(index, 1.0f);
+        ones++;
+    }
+
+    while (true)
+    {
+        int cluster = TightestCluster();
+        pattern[cluster] = false;
+        Splat(cluster, -1.0f);
+
+        int hole = LargestVoid();
+        pattern[hole] = true;
+        Splat(hole, 1.0f);
+
+        if (hole == cluster)
+            break;
+    }
+
+    std::vector<bool>  prototype = pattern;
+    std::vector<float> prototypeEnergy = energy;
+    std::vector<int>   rank(pixelCount, 0);
+
+    // 2. remove the tightest clusters of the prototype: ranks ones - 1 ~ 0.
+    for (int r = ones - 1; r >= 0; r--)
+    {
+        int cluster = TightestCluster();
+        pattern[cluster] = false;
+        Splat(cluster, -1.0f);
+        rank[cluster] = r;
+    }
+
+    // 3. fill the largest voids starting from the prototype: ranks ones ~ pixelCount - 1.
+    pattern = prototype;
+    energy = prototypeEnergy;
+    for (int r = ones; r < pixelCount; r++)
+    {
+        int hole = LargestVoid();
+        pattern[hole] = true;
+        Splat(hole, 1.0f);
+        rank[hole] = r;
+    }
+
+    for (int i = 0; i < pixelCount; i++)
+        noiseData[i] = (rank[i] + 0.5f) / pixelCount;
+
+    energy.clear();
+    pattern.clear();
+}
+
+void BlueNoise::GenerateNoiseTexture()
+{
+    GenerateNoiseData();
+
+    glGenTextures(1, &noiseTextureID);
+    glBindTexture(GL_TEXTURE_2D, noiseTextureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, size, size, 0, GL_RED, GL_FLOAT, noiseData.data());
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+void BlueNoise::UseNoiseTexture()
+{
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, noiseTextureID);
+}
+
+#endif
@@ -30,15 +30,14 @@ public:
     float MovementSpeed;
     float MouseSensitivity;
 
-    float *vertices;
-
     Camera(glm::vec3 position = Global::CameraPos,
            glm::vec3 front = Global::WorldFront,
            glm::vec3 left = Global::WorldLeft);
 
     ~Camera();
 
-    void GenerateRay();
+    void GenerateUniformBlock();
+    void UpdateUniformBlock(int width = Global::WindowWidth, int height = Global::WindowHeight) const;
 
     glm::mat4 GetRotateMatrix() const;
 
@@ -46,7 +45,13 @@ public:
 
     void ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
 
+    bool ConsumeMoved();
+
 private:
+    unsigned int uniformBlockID;
+
+    bool moved;   // position or orientation changed since the last ConsumeMoved()
+
     void UpdateCameraVectors();
 };
 
@@ -60,37 +65,41 @@ Camera::Camera(glm::vec3 position,
       Pitch(0.0f),
       //Roll(0.0f),
       MovementSpeed(Global::CameraSpeed),
-      MouseSensitivity(Global::CameraSensitivity)
+      MouseSensitivity(Global::CameraSensitivity),
+      uniformBlockID(0),
+      moved(false)
 {
-    vertices = new float[Global::PixelCount * 5];
 }
 
 Camera::~Camera()
 {
-    delete[] vertices;
 }
 
-void Camera::GenerateRay()
+// std140 layout of CameraBlock in SimplePathTracing.fs:
+//     mat4 RayRotateMatrix; vec4 Eye; vec4 Screen (width, height, tan(FOV / 2), aspect ratio)
+// Rays are generated per fragment from these, so the camera no longer keeps a per-pixel ray buffer.
+void Camera::GenerateUniformBlock()
 {
-    int counter = 0;
+    glGenBuffers(1, &uniformBlockID);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBlockID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) + 2 * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, Global::CameraBlockBinding, uniformBlockID);
 
-    for (int j = 0; j < Global::WindowHeight; ++j)
-    {
-        for (int i = 0; i < Global::WindowWidth; ++i)
-        {
-            float worldSpaceCoordX = 2 * ((float)i + 0.5) / (float)Global::WindowWidth - 1;
-            float worldSpaceCoordY = 2 * ((float)j + 0.5) / (float)Global::WindowHeight - 1; // OpenGL 屏幕坐标原点在左下角
-
-            float x = worldSpaceCoordX * Global::ImageAspectRatio * Global::Scale;
-            float y = worldSpaceCoordY * Global::Scale;
-            glm::vec3 dir = normalize(glm::vec3(x, y, 1));
-
-            for (int temp = 0; temp < 3; temp++)
-                vertices[counter++] = dir[temp];
-            vertices[counter++] = worldSpaceCoordX;
-            vertices[counter++] = worldSpaceCoordY;
-        }
-    }
+    UpdateUniformBlock();
+}
+
+// width and height are the render resolution, smaller than the window while DynamicResolution reduces it.
+// The aspect ratio and field of view stay those of the window.
+void Camera::UpdateUniformBlock(int width, int height) const
+{
+    glm::mat4 rotate = GetRotateMatrix();
+    glm::vec4 eye(Position, 1.0f);
+    glm::vec4 screen(width, height, Global::Scale, Global::ImageAspectRatio);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBlockID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), &rotate[0][0]);
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::vec4), &eye[0]);
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) + sizeof(glm::vec4), sizeof(glm::vec4), &screen[0]);
 }
 
 glm::mat4 Camera::GetRotateMatrix() const
@@ -114,10 +123,15 @@ void Camera::ProcessKeyboard(CameraMovement direction, float deltaTime)
         Position += Left * velocity;
     if (direction == RIGHT)
         Position -= Left * velocity;
+
+    moved = true;
 }
 
 void Camera::ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch)
 {
+    if (xoffset == 0.0f && yoffset == 0.0f)
+        return;
+
     xoffset *= MouseSensitivity;
     yoffset *= MouseSensitivity;
 
@@ -135,6 +149,16 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, bool constrainPi
 
     // update Front, Right and Up Vectors using the updated Euler angles
     UpdateCameraVectors();
+
+    moved = true;
+}
+
+// Returns whether the camera moved since the last call.
+bool Camera::ConsumeMoved()
+{
+    bool result = moved;
+    moved = false;
+    return result;
 }
 
 void Camera::UpdateCameraVectors()
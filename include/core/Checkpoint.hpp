@@ -0,0 +1,163 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "BatchRenderer.hpp"
+
+/* Checkpoint
+ * Render state of a headless render on disk, so a killed render continues where its last checkpoint left off:
+ *     header     : magic, version and the settings the samples depend on, a mismatch refuses to resume
+ *     progress   : first sample of the next pass (the RNG state, samples are a function of their index),
+ *                  samples per pixel, BatchRenderer::WriteState()
+ *     accumulation: RGBA32F sums and counts, R32F moments, exactly as on the GPU
+ * Passes have Global::BatchPassSamples samples, so a resumed render traces the same passes as an uninterrupted one
+ * and its image is bit-identical.
+ * Save() writes to <file>.tmp and renames it over the file, a render killed while saving keeps the last checkpoint.
+ */
+class Checkpoint
+{
+private:
+    static constexpr char Magic[8] = { 'N', 'P', 'T', 'C', 'K', 'P', 'T', '\0' };
+    static const int Version = 1;
+
+    const std::string fileName;
+
+    std::vector<float> pixels;
+    std::vector<float> moments;
+
+public:
+    Checkpoint(const std::string &fileName);
+    ~Checkpoint() {}
+
+    bool Save(AccumulationBuffer &accumulation, int sampleIndex, int stratification, const BatchRenderer &batch);
+    bool Load(AccumulationBuffer &accumulation, int &sampleIndex, int stratification, BatchRenderer &batch);
+
+    const std::string &GetFileName() const { return fileName; }
+
+    static bool ReplaceFile(const std::string &temporary, const std::string &fileName);
+};
+
+constexpr char Checkpoint::Magic[8];
+
+Checkpoint::Checkpoint(const std::string &fileName) : fileName(fileName)
+{
+}
+
+// After a completed pass: sampleIndex is the first sample of the next one.
+bool Checkpoint::Save(AccumulationBuffer &accumulation, int sampleIndex, int stratification, const BatchRenderer &batch)
+{
+    accumulation.ReadBack(pixels, moments);
+
+    RenderSettings settings = RenderSettings::Current(stratification);
+    int version = Version;
+    int samples = accumulation.GetSampleCount();
+
+    std::string temporary = fileName + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            std::cout << "ERROR::CHECKPOINT::FILE_NOT_SUCCESSFULLY_OPENED " << temporary << std::endl;
+            return false;
+        }
+
+        stream.write(Magic, sizeof(Magic));
+        stream.write((const char *)&version, sizeof(version));
+        stream.write((const char *)&settings, sizeof(settings));
+        stream.write((const char *)&sampleIndex, sizeof(sampleIndex));
+        stream.write((const char *)&samples, sizeof(samples));
+        batch.WriteState(stream);
+        stream.write((const char *)pixels.data(), pixels.size() * sizeof(float));
+        stream.write((const char *)moments.data(), moments.size() * sizeof(float));
+
+        stream.flush();
+        if (!stream)
+        {
+            std::cout << "ERROR::CHECKPOINT::FILE_NOT_SUCCESSFULLY_WRITTEN " << temporary << std::endl;
+            return false;
+        }
+    }
+
+    return ReplaceFile(temporary, fileName);
+}
+
+// Renames the complete temporary over fileName. std::rename doesn't replace an existing file on Windows,
+// so the old one moves aside to <file>.old first, Load() falls back to it if the process dies in between.
+bool Checkpoint::ReplaceFile(const std::string &temporary, const std::string &fileName)
+{
+    if (std::ifstream(fileName))
+    {
+        std::remove((fileName + ".old").c_str());
+        std::rename(fileName.c_str(), (fileName + ".old").c_str());
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        std::cout << "ERROR::CHECKPOINT::FILE_NOT_SUCCESSFULLY_RENAMED " << fileName << std::endl;
+        return false;
+    }
+    std::remove((fileName + ".old").c_str());
+
+    return true;
+}
+
+bool Checkpoint::Load(AccumulationBuffer &accumulation, int &sampleIndex, int stratification, BatchRenderer &batch)
+{
+    // a render killed between the renames of Save() left its last checkpoint in <file>.old.
+    std::ifstream stream(fileName, std::ios::binary);
+    if (!stream)
+        stream.open(fileName + ".old", std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "ERROR::CHECKPOINT::FILE_NOT_SUCCESSFULLY_READ " << fileName << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(Magic)];
+    int version = 0;
+    RenderSettings settings;
+    RenderSettings expected = RenderSettings::Current(stratification);
+
+    stream.read(magic, sizeof(magic));
+    stream.read((char *)&version, sizeof(version));
+    stream.read((char *)&settings, sizeof(settings));
+
+    if (!stream || std::memcmp(magic, Magic, sizeof(Magic)) != 0 || version != Version)
+    {
+        std::cout << "ERROR::CHECKPOINT::NOT_A_CHECKPOINT " << fileName << std::endl;
+        return false;
+    }
+    if (!(settings == expected))
+    {
+        std::cout << "ERROR::CHECKPOINT::SETTINGS_MISMATCH " << fileName
+                  << " was rendered with other resolution, backend, sampler, depth, --spp or pass settings" << std::endl;
+        return false;
+    }
+
+    int samples = 0;
+    stream.read((char *)&sampleIndex, sizeof(sampleIndex));
+    stream.read((char *)&samples, sizeof(samples));
+
+    pixels.resize(4 * Global::PixelCount);
+    moments.resize(Global::PixelCount);
+
+    if (!batch.ReadState(stream) ||
+        !stream.read((char *)pixels.data(), pixels.size() * sizeof(float)) ||
+        !stream.read((char *)moments.data(), moments.size() * sizeof(float)))
+    {
+        std::cout << "ERROR::CHECKPOINT::FILE_TRUNCATED " << fileName << std::endl;
+        return false;
+    }
+
+    accumulation.Restore(pixels, moments, samples);
+    return true;
+}
+
+#endif
@@ -0,0 +1,291 @@
+#ifndef DENOISER_HPP
+#define DENOISER_HPP
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "shader.hpp"
+#include "ShaderCache.hpp"
+
+/* Denoiser
+ * Edge-avoiding A-trous wavelet filter over the accumulation (Dammertz et al., 2010), guided by the first hit's
+ * albedo, normal and distance the tracer writes to AccumulationBuffer's feature textures:
+ *     DenoisePrepare.fs: average radiance / albedo (the texture-free illumination) and the variance of its estimate,
+ *                        from the pixel's moments once it has Global::DenoiseTemporalSamples, else from its neighbours
+ *     DenoiseAtrous.fs : Global::DenoiseIterations 5x5 passes with 1, 2, 4, ... pixels between the taps, weights stop
+ *                        at normal, distance and albedo edges and at luminance differences the noise doesn't explain
+ *                        (Schied et al., 2017), the last pass multiplies the albedo back in
+ * The result is an RGBA32F texture like the accumulation with a count of 1, so the display pass and FrameSaver use
+ * it unchanged. Two textures ping-pong between the passes, which draw the display pass' fullscreen triangle.
+ * RunCpu() is the same filter on the CPU, on a readback of the accumulation.
+ */
+class Denoiser
+{
+private:
+    static constexpr float MinAlbedo = 0.01f;   // keep in sync with MIN_ALBEDO in DenoisePrepare.fs and DenoiseAtrous.fs
+
+    Shader &prepareShader;
+    Shader &atrousShader;
+
+    unsigned int framebufferID[2];
+    unsigned int textureID[2];
+    unsigned int vertexArrayID;
+
+    int current;   // index of the texture holding the last result
+
+    static float Luminance(const float *color) { return 0.2126f * color[0] + 0.7152f * color[1] + 0.0722f * color[2]; }
+
+public:
+    Denoiser(ShaderCache &cache);
+    ~Denoiser() {}
+
+    void Generate();
+
+    void Run(AccumulationBuffer &accumulation, int width = Global::WindowWidth, int height = Global::WindowHeight);
+    void RunCpu(AccumulationBuffer &accumulation, std::vector<float> &output);
+
+    void UseTexture();
+    void BindReadBuffer();
+};
+
+constexpr float Denoiser::MinAlbedo;
+
+Denoiser::Denoiser(ShaderCache &cache)
+    : prepareShader(cache.Get("Display.vs", "DenoisePrepare.fs")), atrousShader(cache.Get("Display.vs", "DenoiseAtrous.fs")),
+      current(0)
+{
+}
+
+// On the context that runs the passes, its vertex array isn't shared.
+void Denoiser::Generate()
+{
+    glGenTextures(2, textureID);
+    glGenFramebuffers(2, framebufferID);
+    glGenVertexArrays(1, &vertexArrayID);
+
+    for (int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+        // linear like the accumulation, the display pass upsamples reduced resolutions.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID[i], 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::DENOISER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    prepareShader.use();
+    prepareShader.setInt("Accumulation", 3);
+    prepareShader.setInt("Moments", 5);
+    prepareShader.setInt("Albedo", 6);
+    prepareShader.setInt("TemporalSamples", Global::DenoiseTemporalSamples);
+
+    atrousShader.use();
+    atrousShader.setInt("Albedo", 6);
+    atrousShader.setInt("Normal", 7);
+    atrousShader.setInt("Illumination", 8);
+    atrousShader.setFloat("SigmaLuminance", Global::DenoiseSigmaLuminance);
+    atrousShader.setFloat("SigmaNormal", Global::DenoiseSigmaNormal);
+    atrousShader.setFloat("SigmaDepth", Global::DenoiseSigmaDepth);
+    atrousShader.setFloat("SigmaAlbedo", Global::DenoiseSigmaAlbedo);
+}
+
+// Filters the latest accumulation, whose lower left width x height texels were rendered, into the texture of
+// UseTexture() and BindReadBuffer(). Leaves the default framebuffer bound.
+void Denoiser::Run(AccumulationBuffer &accumulation, int width, int height)
+{
+    accumulation.UseTexture();
+    accumulation.UseMomentTexture();
+    accumulation.UseFeatureTextures();
+
+    glViewport(0, 0, width, height);
+    glBindVertexArray(vertexArrayID);
+
+    current = 0;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[current]);
+
+    prepareShader.use();
+    prepareShader.setIVec2("RenderSize", width, height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    atrousShader.use();
+    atrousShader.setIVec2("RenderSize", width, height);
+
+    for (int iteration = 0; iteration < Global::DenoiseIterations; iteration++)
+    {
+        glActiveTexture(GL_TEXTURE8);
+        glBindTexture(GL_TEXTURE_2D, textureID[current]);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[1 - current]);
+
+        atrousShader.setInt("StepSize", 1 << iteration);
+        atrousShader.setBool("Modulate", iteration == Global::DenoiseIterations - 1);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        current = 1 - current;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Same filter as Run() over the whole latest accumulation, output: RGBA like the accumulation, bottom row first.
+void Denoiser::RunCpu(AccumulationBuffer &accumulation, std::vector<float> &output)
+{
+    const int width = Global::WindowWidth;
+    const int height = Global::WindowHeight;
+    const float kernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+    std::vector<float> pixels, moments, albedo, normals;
+    accumulation.ReadBack(pixels, moments);
+    accumulation.ReadBackFeatures(albedo, normals);
+
+    std::vector<float> illumination(4 * Global::PixelCount);
+    std::vector<float> filtered(4 * Global::PixelCount);
+
+    auto isInside = [&](int x, int y) { return x >= 0 && y >= 0 && x < width && y < height; };
+
+    // DenoisePrepare.fs
+    for (int i = 0; i < (int)Global::PixelCount; i++)
+    {
+        float n = std::max(pixels[4 * i + 3], 1.0f);
+        for (int channel = 0; channel < 3; channel++)
+            illumination[4 * i + channel] = pixels[4 * i + channel] / n / std::max(albedo[4 * i + channel], MinAlbedo);
+    }
+
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+        {
+            int i = y * width + x;
+            float n = std::max(pixels[4 * i + 3], 1.0f);
+            float variance = 0.0f;
+
+            if (n >= (float)Global::DenoiseTemporalSamples && moments[i] > 0.0f)
+            {
+                float mean = Luminance(&pixels[4 * i]) / n;
+                float minAlbedo[3] = { std::max(albedo[4 * i], MinAlbedo), std::max(albedo[4 * i + 1], MinAlbedo),
+                                       std::max(albedo[4 * i + 2], MinAlbedo) };
+                float albedoLuminance = Luminance(minAlbedo);
+                variance = std::max(moments[i] / n - mean * mean, 0.0f) / (n * albedoLuminance * albedoLuminance);
+            }
+            else
+            {
+                float sum = 0.0f;
+                float squares = 0.0f;
+                float count = 0.0f;
+
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        if (!isInside(x + dx, y + dy))
+                            continue;
+
+                        float luminance = Luminance(&illumination[4 * ((y + dy) * width + x + dx)]);
+                        sum += luminance;
+                        squares += luminance * luminance;
+                        count += 1.0f;
+                    }
+
+                variance = std::max(squares / count - (sum / count) * (sum / count), 0.0f);
+            }
+
+            illumination[4 * i + 3] = variance;
+        }
+
+    // DenoiseAtrous.fs
+    for (int iteration = 0; iteration < Global::DenoiseIterations; iteration++)
+    {
+        int step = 1 << iteration;
+        bool modulate = iteration == Global::DenoiseIterations - 1;
+
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+            {
+                int i = y * width + x;
+                const float *center = &illumination[4 * i];
+                const float *centerNormal = &normals[4 * i];
+                const float *centerAlbedo = &albedo[4 * i];
+
+                float centerLuminance = Luminance(center);
+                float luminanceScale = Global::DenoiseSigmaLuminance * std::sqrt(center[3]) + 1.0e-6f;
+
+                float weightSum = kernel[0] * kernel[0];
+                float sum[3] = { weightSum * center[0], weightSum * center[1], weightSum * center[2] };
+                float variance = weightSum * weightSum * center[3];
+
+                for (int dy = -2; dy <= 2; dy++)
+                    for (int dx = -2; dx <= 2; dx++)
+                    {
+                        int qx = x + dx * step;
+                        int qy = y + dy * step;
+                        if ((dx == 0 && dy == 0) || !isInside(qx, qy))
+                            continue;
+
+                        int q = qy * width + qx;
+                        const float *value = &illumination[4 * q];
+                        const float *normal = &normals[4 * q];
+                        const float *neighbourAlbedo = &albedo[4 * q];
+
+                        float distance = step * std::sqrt((float)(dx * dx + dy * dy));
+                        float cosine = centerNormal[0] * normal[0] + centerNormal[1] * normal[1] + centerNormal[2] * normal[2];
+                        float albedoDifference = std::sqrt((centerAlbedo[0] - neighbourAlbedo[0]) * (centerAlbedo[0] - neighbourAlbedo[0]) +
+                                                           (centerAlbedo[1] - neighbourAlbedo[1]) * (centerAlbedo[1] - neighbourAlbedo[1]) +
+                                                           (centerAlbedo[2] - neighbourAlbedo[2]) * (centerAlbedo[2] - neighbourAlbedo[2]));
+
+                        float luminanceWeight = std::abs(centerLuminance - Luminance(value)) / luminanceScale;
+                        float depthWeight = std::abs(centerNormal[3] - normal[3]) / (Global::DenoiseSigmaDepth * centerNormal[3] * distance + 1.0e-6f);
+                        float albedoWeight = albedoDifference / Global::DenoiseSigmaAlbedo;
+                        float normalWeight = std::pow(std::max(cosine, 0.0f), Global::DenoiseSigmaNormal);
+
+                        float weight = kernel[std::abs(dx)] * kernel[std::abs(dy)] * normalWeight *
+                                       std::exp(-luminanceWeight - depthWeight - albedoWeight);
+
+                        for (int channel = 0; channel < 3; channel++)
+                            sum[channel] += weight * value[channel];
+                        variance += weight * weight * value[3];
+                        weightSum += weight;
+                    }
+
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    filtered[4 * i + channel] = sum[channel] / weightSum;
+                    if (modulate)
+                        filtered[4 * i + channel] *= std::max(centerAlbedo[channel], MinAlbedo);
+                }
+                filtered[4 * i + 3] = modulate ? 1.0f : variance / (weightSum * weightSum);
+            }
+
+        std::swap(illumination, filtered);
+    }
+
+    output.swap(illumination);
+}
+
+// Last result to texture unit 3 for the display pass.
+void Denoiser::UseTexture()
+{
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, textureID[current]);
+}
+
+// Read framebuffer of the last result, like AccumulationBuffer::BindReadBuffer().
+void Denoiser::BindReadBuffer()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebufferID[current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "Global.hpp"
+
+/* DynamicResolution
+ * Internal render resolution while the camera moves.
+ * A frame time controller scales width and height by the same factor: the cost of a pass follows the pixel count,
+ * so the factor moves by the square root of target / measured frame time. The display pass upsamples the rendered
+ * part of the accumulation (RenderScale in Display.fs). Global::DynamicResolutionHoldTime seconds after the last
+ * camera motion, or whenever samples are accumulated for saving, the resolution snaps back to the window's.
+ * The factor of the last motion is kept, so the next one starts from a resolution that was fast enough, the first
+ * one starts at Global::DynamicResolutionStartScale. A reduced pass is a single draw, so it is also capped to the
+ * pixels TileScheduler fits into Global::TileTimeBudget: that holds from the first reduced frame on, while the frame
+ * time controller needs a reduced frame to measure.
+ */
+class DynamicResolution
+{
+private:
+    float scale;         // factor of the last motion
+    float rendered;      // factor of the last frame, scale or less if capped to the budget
+    float stillTime;     // seconds since the camera last moved
+    bool  isReduced;
+
+    int width;
+    int height;
+
+public:
+    DynamicResolution();
+    ~DynamicResolution() {}
+
+    void Update(bool cameraMoved, float frameTime, bool forceFull, float budgetPixels);
+
+    int  GetWidth() const { return width; }
+    int  GetHeight() const { return height; }
+    bool IsReduced() const { return isReduced; }
+};
+
+DynamicResolution::DynamicResolution()
+    : scale(Global::DynamicResolutionStartScale),
+      rendered(1.0f),
+      stillTime(Global::DynamicResolutionHoldTime),
+      isReduced(false),
+      width(Global::WindowWidth),
+      height(Global::WindowHeight)
+{
+}
+
+// frameTime: seconds of the last frame, measured while the resolution was reduced.
+// budgetPixels: pixels a single draw may cover, TileScheduler::GetBudgetPixels().
+void DynamicResolution::Update(bool cameraMoved, float frameTime, bool forceFull, float budgetPixels)
+{
+    stillTime = cameraMoved ? 0.0f : stillTime + frameTime;
+
+    bool wasReduced = isReduced;
+    isReduced = Global::DynamicResolution && !forceFull && stillTime < Global::DynamicResolutionHoldTime;
+
+    // only frames rendered at a reduced resolution tell how fast the reduced resolution is.
+    if (isReduced && wasReduced && frameTime > 0.0f)
+    {
+        float target = rendered * std::sqrt(0.001f * Global::DynamicResolutionTarget / frameTime);
+        scale = Global::clamp(Global::DynamicResolutionMinScale, 1.0f, 0.5f * scale + 0.5f * target);
+    }
+
+    float budgetScale = std::sqrt(std::max(budgetPixels, 1.0f) / Global::PixelCount);
+    rendered = isReduced ? std::min(scale, budgetScale) : 1.0f;
+    width = std::max(1, (int)(Global::WindowWidth * rendered + 0.5f));
+    height = std::max(1, (int)(Global::WindowHeight * rendered + 0.5f));
+}
+
+#endif
@@ -1,23 +1,69 @@
 #ifndef FRAME_SAVER_HPP
 #define FRAME_SAVER_HPP
 
+#include <glad/glad.h>
+
 #include "Global.hpp"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stbi/stb_image_write.hpp>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+/* FrameSaver
+ * Readbacks go through a ring of Global::ReadbackRingSize pixel buffer objects:
+ * RequestReadback() only queues glReadPixels into the next PBO and a fence, ProcessReadbacks() maps the PBOs
+ * whose fence has signaled, so the readback of frame N completes while frames N + 1 and N + 2 render.
+ * Mapped data is handed to a worker thread which does the tone mapping and writes progress snapshots.
+ */
 class FrameSaver
 {
 private:
+    struct ReadbackJob
+    {
+        std::vector<float> data;
+        int samples;
+        bool isFinal;
+    };
+
     bool bufferIsSaved;
 
     unsigned char *colorBuffer;
-    float *multiSampleBuffer;
 
-    unsigned int counter;
+    // pixel buffer object ring
+    unsigned int pixelBufferID[Global::ReadbackRingSize];
+    GLsync fence[Global::ReadbackRingSize];
+    int readbackSamples[Global::ReadbackRingSize];
+    bool readbackIsFinal[Global::ReadbackRingSize];
+    int readbackHead;
+    int readbackPending;
+
+    // worker thread
+    std::thread worker;
+    std::mutex jobMutex;
+    std::mutex bufferMutex;
+    std::condition_variable jobCondition;
+    std::deque<ReadbackJob> jobs;
+    int busyJobs;
+    bool stopWorker;
+
+    bool RetireReadback(bool block);
+    void WorkerLoop();
 
+    void SaveBuffer(const std::vector<float> &accumulation);
+
+    float ToneMap(float value) const;
+
+    void WriteImage(const char *fileName, Global::ImageType type);
     void WriteAuthor(std::ofstream &outStream);
 
     void WritePNG(const char *fileName);
@@ -28,47 +74,228 @@ public:
     FrameSaver();
     ~FrameSaver();
 
-    int SaveBuffer();
+    void GeneratePixelBuffers();
+
+    void RequestReadback(int samples, bool isFinal);
+    void ProcessReadbacks(bool block);
+    void Flush();
+
+    void SaveAccumulation(const std::vector<float> &accumulation);
     void SaveImage(const char *fileName, Global::ImageType type);
 };
 
-FrameSaver::FrameSaver() : bufferIsSaved(false), counter(0)
+FrameSaver::FrameSaver() : bufferIsSaved(false), readbackHead(0), readbackPending(0), busyJobs(0), stopWorker(false)
 {
     colorBuffer = new unsigned char[3 * Global::PixelCount];
-    multiSampleBuffer = new float[3 * Global::PixelCount];
 }
 
 FrameSaver::~FrameSaver()
 {
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopWorker = true;
+        }
+        jobCondition.notify_all();
+        worker.join();
+    }
+
     delete[] colorBuffer;
-    delete[] multiSampleBuffer;
 }
 
-int FrameSaver::SaveBuffer()
+void FrameSaver::GeneratePixelBuffers()
+{
+    glGenBuffers(Global::ReadbackRingSize, pixelBufferID);
+
+    for (int i = 0; i < Global::ReadbackRingSize; i++)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBufferID[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, 4 * Global::PixelCount * sizeof(float), NULL, GL_STREAM_READ);
+        fence[i] = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    worker = std::thread(&FrameSaver::WorkerLoop, this);
+}
+
+// Reads the bound read framebuffer (RGBA floats) into the next PBO without waiting for the GPU.
+void FrameSaver::RequestReadback(int samples, bool isFinal)
 {
-    if (counter > Global::spp)
-        return 10000;
+    if (readbackPending == Global::ReadbackRingSize)
+        RetireReadback(true);
+
+    int slot = (readbackHead + readbackPending) % Global::ReadbackRingSize;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBufferID[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, Global::WindowWidth, Global::WindowHeight, GL_RGBA, GL_FLOAT, (void *)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readbackSamples[slot] = samples;
+    readbackIsFinal[slot] = isFinal;
+    readbackPending++;
+}
+
+// Maps the oldest PBO if its fence has signaled (or waits for it if block), then queues it for the worker.
+bool FrameSaver::RetireReadback(bool block)
+{
+    if (readbackPending == 0)
+        return false;
+
+    int slot = readbackHead;
+
+    GLenum status = glClientWaitSync(fence[slot], block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, block ? 1000000000ull : 0);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+    {
+        if (!block)
+            return false;
+        glFinish();
+    }
 
-    if (counter++ == Global::spp)
+    glDeleteSync(fence[slot]);
+    fence[slot] = 0;
+
+    ReadbackJob job;
+    job.data.resize(4 * Global::PixelCount);
+    job.samples = readbackSamples[slot];
+    job.isFinal = readbackIsFinal[slot];
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBufferID[slot]);
+    void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4 * Global::PixelCount * sizeof(float), GL_MAP_READ_BIT);
+    if (mapped != nullptr)
     {
-        for (int i = 0; i < 3 * Global::PixelCount; i++)
-            colorBuffer[i] = (unsigned char)multiSampleBuffer[i];
-        return Global::spp;
+        std::memcpy(job.data.data(), mapped, 4 * Global::PixelCount * sizeof(float));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
     }
+    else
+        std::cout << "ERROR::FRAME_SAVER::MAP_BUFFER_FAILED" << std::endl;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readbackHead = (readbackHead + 1) % Global::ReadbackRingSize;
+    readbackPending--;
 
-    glReadBuffer(GL_FRONT);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-    glReadPixels(0, 0, Global::WindowWidth, Global::WindowHeight, GL_RGB, GL_UNSIGNED_BYTE, colorBuffer);
+    if (mapped == nullptr)
+        return true;
 
-    for (int i = 0; i < 3 * Global::PixelCount; i++)
-        multiSampleBuffer[i] += ((float)colorBuffer[i] / (float)Global::spp);
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(std::move(job));
+        busyJobs++;
+    }
+    jobCondition.notify_all();
+
+    return true;
+}
+
+void FrameSaver::ProcessReadbacks(bool block)
+{
+    while (RetireReadback(block))
+        ;
+}
+
+// Blocks until every requested readback has been converted.
+void FrameSaver::Flush()
+{
+    ProcessReadbacks(true);
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobCondition.wait(lock, [this] { return busyJobs == 0; });
+}
+
+void FrameSaver::WorkerLoop()
+{
+    while (true)
+    {
+        ReadbackJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCondition.wait(lock, [this] { return stopWorker || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            SaveBuffer(job.data);
+
+            if (!job.isFinal)
+            {
+                std::string fileName = Global::ImagePath + "progress_spp_" + std::to_string(job.samples) + "." + Global::EnumString[Global::ImageFileType];
+                WriteImage(fileName.c_str(), Global::ImageFileType);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            busyJobs--;
+        }
+        jobCondition.notify_all();
+    }
+}
+
+// Accumulation computed on the CPU (e.g. Denoiser::RunCpu()) as the image of the next SaveImage().
+// Waits for the readbacks in flight, so none of them replaces it.
+void FrameSaver::SaveAccumulation(const std::vector<float> &accumulation)
+{
+    Flush();
+
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    SaveBuffer(accumulation);
+}
+
+// accumulation: RGBA floats read back from AccumulationBuffer, rgb is the sum of radiance and a the sample count.
+// The caller holds bufferMutex.
+void FrameSaver::SaveBuffer(const std::vector<float> &accumulation)
+{
+    for (unsigned int i = 0; i < Global::PixelCount; i++)
+    {
+        float samples = std::max(accumulation[4 * i + 3], 1.0f);
+
+        for (int channel = 0; channel < 3; channel++)
+        {
+            float radiance = accumulation[4 * i + channel] / samples;
+            colorBuffer[3 * i + channel] = (unsigned char)(255.0f * ToneMap(radiance) + 0.5f);
+        }
+    }
 
     bufferIsSaved = true;
+}
+
+// Keep in sync with ToneMap() in Display.fs.
+float FrameSaver::ToneMap(float value) const
+{
+    value *= Global::Exposure;
 
-    return counter;
+    switch (Global::ToneMapping)
+    {
+    case Global::ToneMapType::REINHARD:
+        value = value / (1.0f + value);
+        break;
+    case Global::ToneMapType::ACES:
+        value = (value * (2.51f * value + 0.03f)) / (value * (2.43f * value + 0.59f) + 0.14f);
+        break;
+
+    default:
+        break;
+    }
+
+    return std::pow(Global::clamp(0.0f, 1.0f, value), 1.0f / Global::Gamma);
 }
 
 void FrameSaver::SaveImage(const char *fileName, Global::ImageType type)
+{
+    Flush();
+
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    WriteImage(fileName, type);
+}
+
+void FrameSaver::WriteImage(const char *fileName, Global::ImageType type)
 {
     if (!bufferIsSaved)
         return;
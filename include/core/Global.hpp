@@ -6,9 +6,83 @@ namespace Global
     // path tracing arguments----------------------------------------------------------------------
 
     const int spp = 32;
-    const float RussianRoulette = 0.5f;
+    const int MaxDepth = 16;                      // maximum number of bounces of a path
+    const int RussianRouletteDepth = 3;           // bounces before throughput based Russian Roulette starts
     const float IndirLightContributionRate = 1;
 
+    enum BackendType { FRAGMENT, WAVEFRONT };   // WAVEFRONT runs compute shaders and needs an OpenGL 4.3 context
+    const BackendType Backend = FRAGMENT;
+    const int WavefrontGroupSize = 64;            // keep in sync with WAVEFRONT_GROUP_SIZE in Wavefront.glsl
+    const bool SpecializeShaders = true;          // compile depth, sampler and light area into the shaders instead of uniforms
+
+    // sampling arguments--------------------------------------------------------------------------
+
+    enum SamplerType { INDEPENDENT, STRATIFIED, HALTON, SOBOL, BLUE_NOISE }; // keep in sync with SAMPLER_* in shader
+    const std::string SamplerString[] = { "independent", "stratified", "halton", "sobol", "blue_noise" };
+    const SamplerType Sampler = SOBOL;
+
+    const int BlueNoiseSize = 64;                 // width and height of the blue-noise tile
+    const int BlueNoiseDimensions = 8;            // dimensions beyond this fall back to the PCG hash
+    const unsigned int BlueNoiseSeed = 10086;
+
+    // adaptive sampling arguments---------------------------------------------------------------
+
+    const bool AdaptiveSampling = false;          // pixels whose estimate is accurate enough stop receiving samples, opt-in:
+                                                  // converged pixels keep their noise and stop following the view
+    const float AdaptiveThreshold = 0.05f;        // relative standard error of a pixel's luminance that counts as converged
+    const int AdaptiveMinSamples = 16;            // samples before a pixel's variance estimate is trusted
+    const bool ShowSampleCount = false;           // display samples per pixel (black: none, white: most) instead of the image
+
+    // denoising arguments-----------------------------------------------------------------------
+
+    const bool Denoise = true;                    // display the accumulation through the Denoiser, saved images stay unfiltered
+    const int DenoiseIterations = 5;              // A-trous passes, at least 1, the last one's taps are 2^(N-1) pixels apart
+    const int DenoiseTemporalSamples = 4;         // samples before a pixel's own moments estimate its noise
+    const float DenoiseSigmaLuminance = 4.0f;     // luminance difference in standard deviations of the noise
+    const float DenoiseSigmaNormal = 128.0f;      // exponent of the cosine between the normals
+    const float DenoiseSigmaDepth = 0.05f;        // relative hit distance difference per pixel of distance
+    const float DenoiseSigmaAlbedo = 0.1f;        // albedo difference
+
+    // tile scheduling arguments-------------------------------------------------------------------
+
+    const bool TiledRendering = true;             // fragment backend spreads every sample of the image over several frames
+    const int TileSize = 64;                      // width and height of a tile in pixels
+    const float TileTimeBudget = 12.0f;           // GPU ms of path tracing per frame, keeps the loop (and ProcessInput) near 60 Hz
+    const int MaxSamplesPerPass = 16;             // samples per pixel of one pass when a pass is faster than the budget
+
+    // dynamic resolution arguments----------------------------------------------------------------
+
+    const bool DynamicResolution = true;          // reduced internal resolution while the camera moves
+    const float DynamicResolutionTarget = 16.0f;  // ms per frame the controller aims for
+    const float DynamicResolutionMinScale = 0.25f;
+    const float DynamicResolutionStartScale = 0.5f; // factor of the first motion, before any reduced frame was measured
+    const float DynamicResolutionHoldTime = 0.25f; // seconds without motion before full resolution returns
+
+    // reprojection arguments----------------------------------------------------------------------
+
+    const bool TemporalReprojection = false;      // a camera change reuses the last accumulation instead of restarting (fragment backend)
+    const int ReprojectionHistory = 8;            // samples a reprojected pixel keeps at most, limits ghosting
+    const float ReprojectionTolerance = 0.02f;    // relative depth difference treated as a disocclusion
+
+    // presentation arguments--------------------------------------------------------------------
+
+    const bool ThreadedRendering = true;          // path tracing on a render thread, the main thread handles input and presents at vsync
+
+    // profiling arguments-------------------------------------------------------------------------
+
+    const bool ShowHud = true;                    // frame time, samples/sec, spp and Mrays/s in the top left corner
+    const int HudScale = 2;                       // screen pixels per font pixel
+    const int ProfileWindow = 60;                 // frames of the rolling averages
+    const bool ProfileToCsv = false;              // write the profile to ProfilePath every ProfileInterval seconds
+    const float ProfileInterval = 1.0f;           // seconds between rows of ProfilePath
+
+    // batch arguments-----------------------------------------------------------------------------
+
+    const float BatchProgressInterval = 1.0f;     // seconds between progress lines of a headless render
+    const int BatchPassSamples = 8;               // samples per pixel of a headless pass, fixed so the image doesn't depend on GPU timing
+    const float CheckpointInterval = 300.0f;      // seconds of rendering between checkpoints of a headless render
+    const int MaxTileCopies = 2;                  // workers rendering the same tile at once after idle ones stole it, see TileCoordinator
+
     // constants-----------------------------------------------------------------------------------
 
     const float Pi = 3.1415926535897f;
@@ -36,29 +110,47 @@ namespace Global
     const float CameraRoll = 0.0f;
     const float CameraSpeed = 100.0f;
     const float CameraSensitivity = 0.1f;
+    const unsigned int CameraBlockBinding = 0;    // uniform buffer binding point of CameraBlock
 
     // image configuration-------------------------------------------------------------------------
 
-    const std::string ImagePath = ".\\image\\";
+    const std::string ImagePath = "./image/";
     enum ImageType { PNG, JPG, PPM };
     const std::string EnumString[] = { "png", "jpg", "ppm"};
     const std::string Author = "# Author: zionFisher || GitHub: https://github.com/zionFisher\n# 2021";
     const ImageType ImageFileType = PNG;
     const std::string ImageName = ImagePath + "result_spp_" + std::to_string(spp) + "." + EnumString[ImageFileType];
 
+    enum ToneMapType { CLAMP, REINHARD, ACES };   // keep in sync with TONEMAP_* in Display.fs
+    const ToneMapType ToneMapping = CLAMP;
+    const float Exposure = 1.0f;
+    const float Gamma = 1.0f;
+
+    const int ReadbackRingSize = 3;               // pixel buffer objects in flight, readback of frame N completes during N + 1 and N + 2
+    const int SnapshotInterval = 0;               // write a progress image every N samples while saving, 0 disables
+    const bool RenderAOVs = false;                // also write the AOVs of a saved image as <image>_<aov>.pfm, see AovBuffer
+
+    // benchmark configuration---------------------------------------------------------------------
+
+    const bool RunConvergenceBenchmark = false;   // RMSE versus spp of every sampler, then exit
+    const int BenchmarkMaxSpp = 256;              // power of two
+    const int BenchmarkReferenceSpp = 4096;
+    const std::string BenchmarkPath = ImagePath + "convergence.csv";
+    const std::string ProfilePath = ImagePath + "profile.csv";
+
     // model configuration-------------------------------------------------------------------------
 
     const std::string ModelName = "floor";
 
-    const std::string FloorPath = ".\\model\\cornellbox\\floor.obj";
-    const std::string LeftPath = ".\\model\\cornellbox\\left.obj";
-    const std::string LightPath = ".\\model\\cornellbox\\light.obj";
-    const std::string RightPath = ".\\model\\cornellbox\\right.obj";
-    const std::string ShortboxPath = ".\\model\\cornellbox\\shortbox.obj";
-    const std::string TallboxPath = ".\\model\\cornellbox\\tallbox.obj";
-    const std::string CornellMaterialPath = ".\\model\\cornellbox\\mat.mtl";
+    const std::string FloorPath = "./model/cornellbox/floor.obj";
+    const std::string LeftPath = "./model/cornellbox/left.obj";
+    const std::string LightPath = "./model/cornellbox/light.obj";
+    const std::string RightPath = "./model/cornellbox/right.obj";
+    const std::string ShortboxPath = "./model/cornellbox/shortbox.obj";
+    const std::string TallboxPath = "./model/cornellbox/tallbox.obj";
+    const std::string CornellMaterialPath = "./model/cornellbox/mat.mtl";
 
-    const std::string MtlPath = ".\\model\\StarTreckPhaser\\StarTreckPhaser.mtl";
+    const std::string MtlPath = "./model/StarTreckPhaser/StarTreckPhaser.mtl";
 
     const float DefaultMat[12] = { 0.0f, 0.0f, 0.0f,     // Ka
                                    0.725f, 0.71f, 0.68f, // Kd
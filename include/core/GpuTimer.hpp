@@ -0,0 +1,87 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <glad/glad.h>
+
+/* GpuTimer
+ * GL_TIME_ELAPSED queries around a block of GL commands.
+ * Results arrive a few frames late, so the queries form a ring and Poll() only reads finished ones:
+ * measuring never stalls the pipeline. Begin() skips a frame while every query is still in flight.
+ * GL_TIME_ELAPSED queries can't nest, time sequential passes with one timer each.
+ */
+class GpuTimer
+{
+private:
+    static const int QueryCount = 4;
+
+    unsigned int queryID[QueryCount];
+
+    int  head;            // next query to issue
+    int  pending;         // issued queries without a result yet
+    bool active;          // Begin() issued a query that End() has to close
+
+    double milliseconds;  // latest result
+
+public:
+    GpuTimer() : head(0), pending(0), active(false), milliseconds(0.0) {}
+    ~GpuTimer() {}
+
+    void Generate();
+
+    bool Begin();
+    void End();
+
+    bool Poll();
+
+    double GetMilliseconds() const { return milliseconds; }
+};
+
+void GpuTimer::Generate()
+{
+    glGenQueries(QueryCount, queryID);
+}
+
+// Returns false if this block is not timed.
+bool GpuTimer::Begin()
+{
+    if (pending == QueryCount)
+        return false;
+
+    glBeginQuery(GL_TIME_ELAPSED, queryID[head]);
+    active = true;
+    return true;
+}
+
+void GpuTimer::End()
+{
+    if (!active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    head = (head + 1) % QueryCount;
+    pending++;
+    active = false;
+}
+
+// Reads the oldest query if it is finished, results come out in the order the blocks were timed.
+bool GpuTimer::Poll()
+{
+    if (pending == 0)
+        return false;
+
+    unsigned int oldest = queryID[(head - pending + QueryCount) % QueryCount];
+
+    GLint available = 0;
+    glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &nanoseconds);
+
+    milliseconds = nanoseconds / 1.0e6;
+    pending--;
+    return true;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef HEADLESS_CONTEXT_HPP
+#define HEADLESS_CONTEXT_HPP
+
+#include <glad/glad.h>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+#include <iostream>
+
+#include "Global.hpp"
+
+/* HeadlessContext
+ * OpenGL context without a window or a default framebuffer, for render nodes without a display.
+ * Every pass already renders into FBOs (AccumulationBuffer), headless runs simply never present.
+ * On Linux the context comes from EGL on Mesa's surfaceless platform and is made current without any surface,
+ * so it needs neither an X server nor a GPU: LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe.
+ * Other platforms fall back to an invisible GLFW window.
+ * The destructor releases the context if Destroy() was not called, so main() may return anywhere.
+ */
+class HeadlessContext
+{
+private:
+#if defined(__linux__)
+    EGLDisplay display;
+    EGLContext context;
+
+    static EGLDisplay GetDisplay();
+#else
+    GLFWwindow *window;
+#endif
+
+public:
+    HeadlessContext();
+    ~HeadlessContext() { Destroy(); }
+
+    bool Create(int major, int minor);
+    void Destroy();
+};
+
+#if defined(__linux__)
+
+HeadlessContext::HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT) {}
+
+// The surfaceless platform never touches a window system, EGL_DEFAULT_DISPLAY may try X11 or Wayland first.
+EGLDisplay HeadlessContext::GetDisplay()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    EGLDisplay surfaceless = EGL_NO_DISPLAY;
+    if (getPlatformDisplay != nullptr)
+        surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+    return surfaceless != EGL_NO_DISPLAY ? surfaceless : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool HeadlessContext::Create(int major, int minor)
+{
+    display = GetDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+    {
+        std::cout << "ERROR::HEADLESS::EGL_DISPLAY_NOT_INITIALIZED" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        std::cout << "ERROR::HEADLESS::NO_EGL_CONFIG" << std::endl;
+        return false;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, major,
+                                         EGL_CONTEXT_MINOR_VERSION, minor,
+                                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                         EGL_NONE };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "ERROR::HEADLESS::EGL_CONTEXT_NOT_CREATED " << major << "." << minor << std::endl;
+        return false;
+    }
+
+    // EGL_KHR_surfaceless_context: current without a surface, there is nothing to present.
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cout << "ERROR::HEADLESS::EGL_MAKE_CURRENT_FAILED" << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void HeadlessContext::Destroy()
+{
+    if (display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+}
+
+#else
+
+HeadlessContext::HeadlessContext() : window(nullptr) {}
+
+bool HeadlessContext::Create(int major, int minor)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(1, 1, Global::WindowName.c_str(), NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void HeadlessContext::Destroy()
+{
+    if (window == nullptr)
+        return;
+
+    glfwTerminate();
+    window = nullptr;
+}
+
+#endif
+
+#endif
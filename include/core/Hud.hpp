@@ -0,0 +1,122 @@
+#ifndef HUD_HPP
+#define HUD_HPP
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "Global.hpp"
+#include "Profiler.hpp"
+#include "shader.hpp"
+
+/* Hud
+ * Profiler numbers in the top left corner of the window.
+ * There is no font rendering in the renderer, so Hud.fs draws a built in 3x5 bitmap font:
+ * every character cell becomes one int of the Glyphs uniform, drawn with the display pass' fullscreen triangle
+ * restricted to the HUD by the viewport. Characters without a glyph are drawn as spaces.
+ */
+class Hud
+{
+private:
+    static const int Columns = 20;   // keep in sync with HUD_COLUMNS and HUD_ROWS in Hud.fs
+    static const int Rows = 6;
+
+    Shader &shader;
+    int glyphs[Columns * Rows];
+
+    static int Glyph(char c);
+
+    void SetLine(int row, const std::string &text);
+
+public:
+    Hud(Shader &shader);
+    ~Hud() {}
+
+    void Update(const Profiler &profiler);
+    void Draw(unsigned int VAO, int framebufferWidth, int framebufferHeight);
+};
+
+Hud::Hud(Shader &shader) : shader(shader)
+{
+    for (int i = 0; i < Columns * Rows; i++)
+        glyphs[i] = 0;
+}
+
+// Rows top to bottom, '1' is a lit pixel.
+int Hud::Glyph(char c)
+{
+    static const std::map<char, std::string> font = {
+        { '0', "111101101101111" }, { '1', "010110010010111" }, { '2', "111001111100111" },
+        { '3', "111001111001111" }, { '4', "101101111001001" }, { '5', "111100111001111" },
+        { '6', "111100111101111" }, { '7', "111001001001001" }, { '8', "111101111101111" },
+        { '9', "111101111001111" }, { 'A', "010101111101101" }, { 'D', "110101101101110" },
+        { 'E', "111100110100111" }, { 'F', "111100110100100" }, { 'H', "101101111101101" },
+        { 'I', "111010010010111" }, { 'L', "100100100100111" }, { 'M', "101111111101101" },
+        { 'P', "110101110100100" }, { 'R', "110101110101101" }, { 'S', "011100010001110" },
+        { 'T', "111010010010010" }, { 'Y', "101101010010010" }, { '.', "000000000000010" },
+        { '/', "001001010100100" }, { '-', "000000111000000" }
+    };
+
+    auto it = font.find((char)std::toupper((unsigned char)c));
+    if (it == font.end())
+        return 0;
+
+    return std::stoi(it->second, nullptr, 2);
+}
+
+void Hud::SetLine(int row, const std::string &text)
+{
+    for (int column = 0; column < Columns; column++)
+        glyphs[row * Columns + column] = column < (int)text.size() ? Glyph(text[column]) : 0;
+}
+
+void Hud::Update(const Profiler &profiler)
+{
+    auto line = [](const std::string &label, double value, int precision, const std::string &unit)
+    {
+        std::ostringstream text;
+        text.setf(std::ios::fixed);
+        text.precision(precision);
+        text << label << value << unit;
+        return text.str();
+    };
+
+    double mrays = profiler.GetMRaysPerSecond();
+
+    SetLine(0, line("FRAME   ", profiler.GetFrameTime(), 2, " MS"));
+    SetLine(1, line("PATH    ", profiler.GetGpuTime(GPU_PATH_TRACING), 2, " MS"));
+    SetLine(2, line("DISPLAY ", profiler.GetGpuTime(GPU_DISPLAY), 2, " MS"));
+    SetLine(3, line("SAMPLES/S ", profiler.GetSamplesPerSecond() / 1.0e6, 2, "M"));
+    SetLine(4, line("SPP     ", profiler.GetAccumulatedSpp(), 0, ""));
+    SetLine(5, mrays >= 0.0 ? line("MRAYS/S ", mrays, 1, "") : "MRAYS/S -");
+}
+
+void Hud::Draw(unsigned int VAO, int framebufferWidth, int framebufferHeight)
+{
+    const int margin = 4 * Global::HudScale;
+    const int width = Columns * 4 * Global::HudScale;
+    const int height = Rows * 6 * Global::HudScale;
+    const int x = margin;
+    const int y = framebufferHeight - height - margin;
+
+    glViewport(x, y, std::min(width, framebufferWidth), height);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    shader.use();
+    shader.setIntArray("Glyphs", Columns * Rows, glyphs);
+    shader.setIVec2("Origin", x, y);
+    shader.setInt("HudScale", Global::HudScale);
+
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glDisable(GL_BLEND);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+}
+
+#endif
@@ -14,6 +14,8 @@ private:
     unsigned int modelTextureID;
     unsigned int materialTextureID;
 
+    float receivedLightArea;   // < 0 unless the data came from GenerateTextures(), see TileWorker
+
     void GenerateModelData();
     void GenerateMaterialData();
 
@@ -23,7 +25,7 @@ private:
     void GenerateTexture(unsigned int &textureID, std::vector<float> &data);
 
 public:
-    ModelData(Model &model) : model(model) {}
+    ModelData(Model &model) : model(model), receivedLightArea(-1.0f) {}
     ~ModelData() {}
 
     void GenerateModelTexture();
@@ -32,11 +34,18 @@ public:
     void GenerateBVHModelTexture();
     void GenerateBVHMaterialTexture();
 
+    void GenerateTextures(const std::vector<float> &model, const std::vector<float> &material, float lightArea);
+
+    const std::vector<float> &GetModelData() const { return modelData; }
+    const std::vector<float> &GetMaterialData() const { return materialData; }
+
     void UseModelTexture();
     void UseMaterialTexture();
 
     void PrintModelTexture(unsigned int textureSize);
     void PrintMaterialTexture(unsigned int textureSize);
+
+    float GetLightArea() const;
 };
 
 void ModelData::GenerateModelData()
@@ -124,6 +133,34 @@ void ModelData::GenerateModelData()
     return;
 }
 
+// Total area of all emitting triangles, same sum as GetLightArea() in PathTracingCommon.glsl.
+float ModelData::GetLightArea() const
+{
+    if (receivedLightArea >= 0.0f)
+        return receivedLightArea;
+
+    const std::vector<glm::vec3> &vertices = this->model.GetVertices();
+    const std::vector<SingleModel> &models = this->model.GetModels();
+
+    float area = 0.0f;
+
+    for (auto &it : models)
+    {
+        if (!it.isLight)
+            continue;
+
+        for (auto &face : it.faces)
+        {
+            glm::vec3 v0 = vertices[face[0].x - 1];
+            glm::vec3 v1 = vertices[face[1].x - 1];
+            glm::vec3 v2 = vertices[face[2].x - 1];
+            area += glm::length(glm::cross(v1 - v0, v2 - v0)) * 0.5f;
+        }
+    }
+
+    return area;
+}
+
 void ModelData::GenerateMaterialData()
 {
     // reference
@@ -193,6 +230,17 @@ void ModelData::GenerateMaterialTexture()
     GenerateTexture(materialTextureID, materialData);
 }
 
+// Textures of data generated by another process (GetModelData(), GetMaterialData()), the model stays unloaded.
+void ModelData::GenerateTextures(const std::vector<float> &model, const std::vector<float> &material, float lightArea)
+{
+    modelData = model;
+    materialData = material;
+    receivedLightArea = lightArea;
+
+    GenerateTexture(modelTextureID, modelData);
+    GenerateTexture(materialTextureID, materialData);
+}
+
 void ModelData::UseModelTexture()
 {
     glActiveTexture(GL_TEXTURE0);
@@ -0,0 +1,222 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+
+/* Options
+ * Command line of the renderer, everything else is configured in Global.
+ *     --headless       batch render without a window (HeadlessContext, BatchRenderer), save the image and exit
+ *     --spp N          stop at N samples per pixel, default Global::spp, 0 renders until --time or --noise
+ *     --time S         stop after S seconds of rendering
+ *     --noise T        stop once the estimated relative noise of the image is below T, see BatchRenderer
+ *     --output FILE    headless image, the type follows the extension, default Global::ImageName for N spp
+ *     --stats FILE     statistics of the render as JSON, default the image's path with a .json extension
+ *     --sample-map FILE  samples of every pixel as a grayscale PNG (white: most), see Global::AdaptiveSampling
+ *     --checkpoint FILE  save the render state every Global::CheckpointInterval seconds and when it stops, see Checkpoint
+ *     --resume FILE    continue the render of a checkpoint, which keeps being updated unless --checkpoint names another file
+ *     --coordinator PORT  distribute the render over TileWorker processes and save the assembled image, see TileCoordinator
+ *     --worker HOST:PORT  render tiles for the coordinator at HOST:PORT, the scene and --spp come from it
+ *     --sample-range FIRST:COUNT  render only the samples FIRST ~ FIRST + COUNT - 1 of the --spp N of the frame
+ *     --partial FILE   save the float accumulation for --merge, default the image's path with a .acc extension
+ *                      if --sample-range is given, see PartialAccumulation
+ *     --merge FILE...  sum partial accumulations into --output (and --partial), renders nothing
+ *     --denoise FILE   also save the image filtered by the Denoiser, --denoise-cpu FILE filters on the CPU
+ *     --aovs           also save the AOVs as <output>_<aov>.pfm, see AovBuffer
+ * A headless render stops at whichever limit it reaches first.
+ */
+class Options
+{
+public:
+    bool headless;
+    int samples;            // to render, 0 if unlimited
+    int stratification;     // samples of the whole frame the sampler is stratified over
+    int firstSample;        // index of the first sample to render
+    float timeBudget;       // seconds, 0 if unlimited
+    float noiseThreshold;   // 0 if unlimited
+    std::string output;
+    Global::ImageType outputType;
+    std::string stats;
+    std::string sampleMap;   // empty if not requested
+    std::string checkpoint;  // empty if not requested
+    std::string resume;      // empty if not requested
+    int coordinatorPort;     // 0 if not a coordinator
+    std::string worker;      // coordinator's address, empty if not a worker
+    std::string partial;     // empty if not requested
+    std::vector<std::string> merge;   // partials to merge, empty if rendering
+    std::string denoise;     // denoised image, empty if not requested
+    Global::ImageType denoiseType;
+    bool denoiseOnCpu;       // Denoiser::RunCpu() instead of Denoiser::Run()
+    bool aovs;
+
+    bool valid;   // false if the command line couldn't be parsed
+
+    Options(int argc, char **argv);
+    ~Options() {}
+
+private:
+    static Global::ImageType TypeOf(const std::string &fileName, Global::ImageType type);
+};
+
+Options::Options(int argc, char **argv)
+    : headless(false), samples(Global::spp), stratification(Global::spp), firstSample(0), timeBudget(0.0f), noiseThreshold(0.0f),
+      outputType(Global::ImageFileType), coordinatorPort(0), denoiseType(Global::ImageFileType), denoiseOnCpu(false), aovs(false), valid(true)
+{
+    int rangeCount = 0;
+    bool isMerge = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--headless")
+            headless = true;
+        else if (argument == "--spp" && hasValue)
+            samples = std::max(0, std::atoi(argv[++i]));
+        else if (argument == "--time" && hasValue)
+            timeBudget = std::max(0.0f, (float)std::atof(argv[++i]));
+        else if (argument == "--noise" && hasValue)
+            noiseThreshold = std::max(0.0f, (float)std::atof(argv[++i]));
+        else if (argument == "--output" && hasValue)
+            output = argv[++i];
+        else if (argument == "--stats" && hasValue)
+            stats = argv[++i];
+        else if (argument == "--sample-map" && hasValue)
+            sampleMap = argv[++i];
+        else if (argument == "--checkpoint" && hasValue)
+            checkpoint = argv[++i];
+        else if (argument == "--resume" && hasValue)
+            resume = argv[++i];
+        else if (argument == "--coordinator" && hasValue)
+        {
+            coordinatorPort = std::atoi(argv[++i]);
+            headless = true;
+        }
+        else if (argument == "--worker" && hasValue)
+        {
+            worker = argv[++i];
+            headless = true;
+        }
+        else if (argument == "--sample-range" && hasValue)
+        {
+            std::string range = argv[++i];
+            size_t colon = range.find(':');
+            firstSample = std::max(0, std::atoi(range.c_str()));
+            rangeCount = colon != std::string::npos ? std::max(0, std::atoi(range.c_str() + colon + 1)) : 0;
+        }
+        else if (argument == "--partial" && hasValue)
+            partial = argv[++i];
+        else if ((argument == "--denoise" || argument == "--denoise-cpu") && hasValue)
+        {
+            denoise = argv[++i];
+            denoiseOnCpu = argument == "--denoise-cpu";
+        }
+        else if (argument == "--aovs")
+            aovs = true;
+        else if (argument == "--merge")
+        {
+            while (i + 1 < argc && argv[i + 1][0] != '-')
+                merge.push_back(argv[++i]);
+            isMerge = true;
+            headless = true;
+        }
+        else
+        {
+            std::cout << "ERROR::OPTIONS::UNKNOWN_ARGUMENT " << argument << std::endl;
+            valid = false;
+        }
+    }
+
+    if (samples == 0 && timeBudget == 0.0f && noiseThreshold == 0.0f)
+    {
+        std::cout << "ERROR::OPTIONS::NO_STOP_CRITERION --spp 0 needs --time or --noise" << std::endl;
+        valid = false;
+    }
+
+    if (coordinatorPort > 0 && samples == 0)
+    {
+        std::cout << "ERROR::OPTIONS::NO_SAMPLE_LIMIT --coordinator needs --spp" << std::endl;
+        valid = false;
+    }
+
+    // stratified over the sample limit, or over Global::spp if the render stops at a time or noise limit.
+    stratification = samples > 0 ? samples : Global::spp;
+
+    std::string name = samples > 0 ? "result_spp_" + std::to_string(samples) : "result_batch";
+
+    if (rangeCount > 0)
+    {
+        if (samples == 0 || firstSample + rangeCount > samples)
+        {
+            std::cout << "ERROR::OPTIONS::INVALID_SAMPLE_RANGE --sample-range has to lie within the --spp of the frame" << std::endl;
+            valid = false;
+        }
+
+        samples = rangeCount;
+        name += "_samples_" + std::to_string(firstSample) + "_" + std::to_string(firstSample + rangeCount - 1);
+    }
+    else if (firstSample > 0)
+    {
+        std::cout << "ERROR::OPTIONS::INVALID_SAMPLE_RANGE expected --sample-range FIRST:COUNT" << std::endl;
+        valid = false;
+    }
+
+    if (isMerge)
+    {
+        if (merge.empty())
+        {
+            std::cout << "ERROR::OPTIONS::NOTHING_TO_MERGE --merge needs partial accumulation files" << std::endl;
+            valid = false;
+        }
+        name = "result_merged";
+    }
+
+    // the features guiding the filter are written while tracing, a coordinator or a merge traces nothing.
+    if (!denoise.empty() && (coordinatorPort > 0 || !worker.empty() || isMerge))
+    {
+        std::cout << "ERROR::OPTIONS::NOTHING_TO_DENOISE --denoise needs a render of this process" << std::endl;
+        valid = false;
+    }
+
+    // direct lighting is accumulated while tracing and isn't part of a checkpoint, tile or partial accumulation.
+    if (aovs && (coordinatorPort > 0 || !worker.empty() || isMerge || !resume.empty()))
+    {
+        std::cout << "ERROR::OPTIONS::NO_AOVS --aovs needs a render of this process from its first sample" << std::endl;
+        valid = false;
+    }
+
+    if (output.empty())
+        output = Global::ImagePath + name + "." + Global::EnumString[outputType];
+    else
+        outputType = TypeOf(output, outputType);
+
+    denoiseType = TypeOf(denoise, denoiseType);
+
+    if (stats.empty())
+        stats = output.substr(0, output.find_last_of('.')) + ".json";
+
+    if (checkpoint.empty())
+        checkpoint = resume;
+
+    if (partial.empty() && rangeCount > 0)
+        partial = output.substr(0, output.find_last_of('.')) + ".acc";
+}
+
+// Image type of the file's extension, type if it has none of Global::EnumString.
+Global::ImageType Options::TypeOf(const std::string &fileName, Global::ImageType type)
+{
+    std::string extension = fileName.substr(fileName.find_last_of('.') + 1);
+    for (int each = Global::PNG; each <= Global::PPM; each++)
+        if (extension == Global::EnumString[each])
+            return (Global::ImageType)each;
+
+    return type;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef PARTIAL_ACCUMULATION_HPP
+#define PARTIAL_ACCUMULATION_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "BatchRenderer.hpp"
+#include "Checkpoint.hpp"
+
+/* PartialAccumulation
+ * Float accumulation of some sample indices of a frame, the unit of a sample-space distributed render:
+ * every node renders the whole frame with its own --sample-range of the same --spp and writes a --partial file,
+ * --merge sums any number of them into the final image. No node knows of the others, so preemptible machines can
+ * come and go, a range that was lost is simply rendered again.
+ * Samples only depend on the pixel and their index, so the merged ranges hold the samples of a single render
+ * (with adaptive sampling every node decides convergence from its own samples, so pixels may stop elsewhere).
+ * Radiance sums and per-pixel counts add up, the merged rgb / a therefore weights every partial by the samples it
+ * actually traced, also where adaptive sampling stopped a pixel early.
+ * File: magic, version, RenderSettings, range count, first sample and count of every range, RGBA32F accumulation,
+ * R32F moments. A merge of partials is a partial again, so merges can be merged.
+ */
+class PartialAccumulation
+{
+private:
+    static constexpr char Magic[8] = { 'N', 'P', 'T', 'P', 'A', 'R', 'T', '\0' };
+    static const int Version = 1;
+
+    RenderSettings settings;
+    std::vector<std::pair<int, int>> ranges;   // first sample index and sample count, sorted
+
+    std::vector<float> pixels;    // rgba as in AccumulationBuffer
+    std::vector<float> moments;
+
+public:
+    PartialAccumulation() {}
+    ~PartialAccumulation() {}
+
+    void ReadBack(AccumulationBuffer &accumulation, int stratification, int firstSample);
+    void Restore(AccumulationBuffer &accumulation) const;
+
+    bool Write(const std::string &fileName) const;
+    bool Read(const std::string &fileName);
+
+    bool Merge(const PartialAccumulation &other);
+
+    int GetSampleCount() const;
+    int GetStratification() const { return settings.stratification; }
+};
+
+constexpr char PartialAccumulation::Magic[8];
+
+// The accumulation holds the samples firstSample ~ firstSample + GetSampleCount() - 1.
+void PartialAccumulation::ReadBack(AccumulationBuffer &accumulation, int stratification, int firstSample)
+{
+    settings = RenderSettings::Current(stratification);
+    ranges.assign(1, std::make_pair(firstSample, accumulation.GetSampleCount()));
+    accumulation.ReadBack(pixels, moments);
+}
+
+void PartialAccumulation::Restore(AccumulationBuffer &accumulation) const
+{
+    accumulation.Restore(pixels, moments, GetSampleCount());
+}
+
+int PartialAccumulation::GetSampleCount() const
+{
+    int samples = 0;
+    for (const std::pair<int, int> &range : ranges)
+        samples += range.second;
+    return samples;
+}
+
+bool PartialAccumulation::Write(const std::string &fileName) const
+{
+    int version = Version;
+    int rangeCount = (int)ranges.size();
+
+    std::string temporary = fileName + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            std::cout << "ERROR::PARTIAL_ACCUMULATION::FILE_NOT_SUCCESSFULLY_OPENED " << temporary << std::endl;
+            return false;
+        }
+
+        stream.write(Magic, sizeof(Magic));
+        stream.write((const char *)&version, sizeof(version));
+        stream.write((const char *)&settings, sizeof(settings));
+        stream.write((const char *)&rangeCount, sizeof(rangeCount));
+        for (const std::pair<int, int> &range : ranges)
+        {
+            stream.write((const char *)&range.first, sizeof(range.first));
+            stream.write((const char *)&range.second, sizeof(range.second));
+        }
+        stream.write((const char *)pixels.data(), pixels.size() * sizeof(float));
+        stream.write((const char *)moments.data(), moments.size() * sizeof(float));
+
+        stream.flush();
+        if (!stream)
+        {
+            std::cout << "ERROR::PARTIAL_ACCUMULATION::FILE_NOT_SUCCESSFULLY_WRITTEN " << temporary << std::endl;
+            return false;
+        }
+    }
+
+    return Checkpoint::ReplaceFile(temporary, fileName);
+}
+
+bool PartialAccumulation::Read(const std::string &fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "ERROR::PARTIAL_ACCUMULATION::FILE_NOT_SUCCESSFULLY_READ " << fileName << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(Magic)];
+    int version = 0;
+    int rangeCount = 0;
+
+    stream.read(magic, sizeof(magic));
+    stream.read((char *)&version, sizeof(version));
+    stream.read((char *)&settings, sizeof(settings));
+    stream.read((char *)&rangeCount, sizeof(rangeCount));
+
+    if (!stream || std::memcmp(magic, Magic, sizeof(Magic)) != 0 || version != Version || rangeCount < 0)
+    {
+        std::cout << "ERROR::PARTIAL_ACCUMULATION::NOT_A_PARTIAL_ACCUMULATION " << fileName << std::endl;
+        return false;
+    }
+
+    // the accumulation is restored into this build's buffers.
+    if (settings.width != (int)Global::WindowWidth || settings.height != (int)Global::WindowHeight)
+    {
+        std::cout << "ERROR::PARTIAL_ACCUMULATION::RESOLUTION_MISMATCH " << fileName << " is "
+                  << settings.width << "x" << settings.height << std::endl;
+        return false;
+    }
+
+    ranges.resize(rangeCount);
+    for (std::pair<int, int> &range : ranges)
+    {
+        stream.read((char *)&range.first, sizeof(range.first));
+        stream.read((char *)&range.second, sizeof(range.second));
+    }
+
+    pixels.resize(4 * Global::PixelCount);
+    moments.resize(Global::PixelCount);
+    stream.read((char *)pixels.data(), pixels.size() * sizeof(float));
+    stream.read((char *)moments.data(), moments.size() * sizeof(float));
+
+    if (!stream)
+    {
+        std::cout << "ERROR::PARTIAL_ACCUMULATION::FILE_TRUNCATED " << fileName << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Adds the samples of other, which has to come from the same settings and hold other sample indices.
+// An empty partial takes over the first one merged into it.
+bool PartialAccumulation::Merge(const PartialAccumulation &other)
+{
+    if (ranges.empty())
+    {
+        *this = other;
+        return true;
+    }
+
+    if (!(settings == other.settings))
+    {
+        std::cout << "ERROR::PARTIAL_ACCUMULATION::SETTINGS_MISMATCH partials of different renders" << std::endl;
+        return false;
+    }
+
+    // the same sample twice would count twice.
+    for (const std::pair<int, int> &range : ranges)
+        for (const std::pair<int, int> &otherRange : other.ranges)
+            if (range.first < otherRange.first + otherRange.second && otherRange.first < range.first + range.second)
+            {
+                std::cout << "ERROR::PARTIAL_ACCUMULATION::OVERLAPPING_SAMPLES " << otherRange.first << " ~ "
+                          << otherRange.first + otherRange.second - 1 << " were merged already" << std::endl;
+                return false;
+            }
+
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] += other.pixels[i];
+    for (size_t i = 0; i < moments.size(); i++)
+        moments[i] += other.moments[i];
+
+    ranges.insert(ranges.end(), other.ranges.begin(), other.ranges.end());
+    std::sort(ranges.begin(), ranges.end());
+
+    return true;
+}
+
+#endif
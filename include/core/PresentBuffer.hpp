@@ -0,0 +1,179 @@
+#ifndef PRESENT_BUFFER_HPP
+#define PRESENT_BUFFER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <mutex>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "Denoiser.hpp"
+
+/* PresentBuffer
+ * Hands completed accumulations from the render thread to the presenter thread, which run on two shared contexts.
+ * Three RGBA32F copies form a mailbox: the render thread fills one, one holds the latest complete accumulation and
+ * the presenter shows the third. Publish() and Acquire() only swap indices, neither thread ever waits for the other,
+ * so the presenter keeps showing the latest accumulation at vsync however long a pass takes.
+ * GPU ordering between the contexts is kept by fences: a published copy is only shown once its fence signaled,
+ * until then the presenter keeps the previous one, and the presenter's draw is waited for before its texture is
+ * written again.
+ * Textures are shared between contexts, framebuffers are not: Generate() runs on the render thread's context.
+ */
+class PresentBuffer
+{
+private:
+    static const int SlotCount = 3;
+
+    unsigned int textureID[SlotCount];
+    unsigned int framebufferID[SlotCount];   // render thread's context only
+
+    GLsync copied[SlotCount];   // copy into the slot finished, waited for by the presenter
+    GLsync shown[SlotCount];    // presenter's draw from the slot finished, waited for by the render thread
+
+    glm::vec2 renderScale[SlotCount];
+    int sampleCount[SlotCount];   // AccumulationBuffer::GetSampleCount() of the copy
+
+    int writeSlot;
+    int readySlot;
+    int displaySlot;
+    bool isNewFrame;
+
+    std::mutex slotMutex;
+
+public:
+    PresentBuffer();
+    ~PresentBuffer() {}
+
+    void Generate();
+
+    void Publish(AccumulationBuffer &accumulation, const glm::vec2 &scale, Denoiser *denoiser = nullptr);
+
+    glm::vec2 Acquire();
+    void Release();
+
+    int GetSampleCount() const { return sampleCount[displaySlot]; }
+
+private:
+    static bool IsSignaled(GLsync sync);
+};
+
+PresentBuffer::PresentBuffer() : writeSlot(0), readySlot(1), displaySlot(2), isNewFrame(false)
+{
+    for (int i = 0; i < SlotCount; i++)
+    {
+        copied[i] = 0;
+        shown[i] = 0;
+        renderScale[i] = glm::vec2(1.0f);
+        sampleCount[i] = 0;
+    }
+}
+
+void PresentBuffer::Generate()
+{
+    glGenTextures(SlotCount, textureID);
+    glGenFramebuffers(SlotCount, framebufferID);
+
+    for (int i = 0; i < SlotCount; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Global::WindowWidth, Global::WindowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebufferID[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID[i], 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::PRESENT_BUFFER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glFlush();
+}
+
+// Render thread: copies the latest accumulation into the free slot and makes it the one to show next.
+// scale: rendered part of the accumulation, see RenderScale in Display.fs.
+// denoiser: copies its last result of the accumulation instead, if given.
+void PresentBuffer::Publish(AccumulationBuffer &accumulation, const glm::vec2 &scale, Denoiser *denoiser)
+{
+    if (shown[writeSlot] != 0)
+    {
+        glWaitSync(shown[writeSlot], 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(shown[writeSlot]);
+        shown[writeSlot] = 0;
+    }
+
+    if (denoiser != nullptr)
+        denoiser->BindReadBuffer();
+    else
+        accumulation.BindReadBuffer();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferID[writeSlot]);
+    glBlitFramebuffer(0, 0, Global::WindowWidth, Global::WindowHeight,
+                      0, 0, Global::WindowWidth, Global::WindowHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // a slot published but never shown still holds its fence.
+    if (copied[writeSlot] != 0)
+        glDeleteSync(copied[writeSlot]);
+    copied[writeSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    renderScale[writeSlot] = scale;
+    sampleCount[writeSlot] = accumulation.GetSampleCount();
+
+    // the presenter's context only sees the fence once it reached the GPU.
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(slotMutex);
+    std::swap(writeSlot, readySlot);
+    isNewFrame = true;
+}
+
+// Presenter thread: binds the latest accumulation whose copy finished to texture unit 3 and returns its render scale.
+glm::vec2 PresentBuffer::Acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (isNewFrame && IsSignaled(copied[readySlot]))
+        {
+            std::swap(readySlot, displaySlot);
+            isNewFrame = false;
+
+            glDeleteSync(copied[displaySlot]);
+            copied[displaySlot] = 0;
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, textureID[displaySlot]);
+
+    return renderScale[displaySlot];
+}
+
+// Presenter thread: after the draws sampling the acquired slot.
+void PresentBuffer::Release()
+{
+    std::lock_guard<std::mutex> lock(slotMutex);
+
+    if (shown[displaySlot] != 0)
+        glDeleteSync(shown[displaySlot]);
+    shown[displaySlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+bool PresentBuffer::IsSignaled(GLsync sync)
+{
+    if (sync == 0)
+        return true;
+
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(sync, GL_SYNC_STATUS, 1, NULL, &status);
+    return status == GL_SIGNALED;
+}
+
+#endif
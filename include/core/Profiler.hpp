@@ -0,0 +1,243 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "GpuTimer.hpp"
+
+enum ProfileGpuPass { GPU_PATH_TRACING, GPU_DISPLAY, GPU_PASS_COUNT };
+enum ProfileCpuTask { CPU_INPUT, CPU_UPLOAD, CPU_READBACK, CPU_TASK_COUNT };
+
+/* RollingAverage
+ * Mean of the last Global::ProfileWindow values.
+ */
+class RollingAverage
+{
+private:
+    std::vector<double> values;
+    int next;
+    int count;
+
+public:
+    RollingAverage() : values(Global::ProfileWindow, 0.0), next(0), count(0) {}
+
+    void Add(double value)
+    {
+        values[next] = value;
+        next = (next + 1) % values.size();
+        count = std::min(count + 1, (int)values.size());
+    }
+
+    double Mean() const
+    {
+        double sum = 0.0;
+        for (int i = 0; i < count; i++)
+            sum += values[i];
+        return count > 0 ? sum / count : 0.0;
+    }
+};
+
+/* Profiler
+ * Where the frame time goes: GPU time of every pass (GpuTimer), CPU time of input, upload and readback,
+ * frame time, samples and rays per second, all as rolling averages over Global::ProfileWindow frames.
+ * The same numbers feed the HUD and, once per Global::ProfileInterval seconds, a row of Global::ProfilePath.
+ * With Global::ThreadedRendering the render and presenter threads both report here, so every method locks.
+ * Query objects belong to one context: GenerateTimer() and Begin/EndGpu() of a pass run on the thread drawing it.
+ */
+class Profiler
+{
+private:
+    GpuTimer gpuTimers[GPU_PASS_COUNT];
+    double   gpuLatest[GPU_PASS_COUNT];   // latest result, results arrive a few frames late
+
+    std::chrono::steady_clock::time_point cpuStart[CPU_TASK_COUNT];
+    double cpuLatest[CPU_TASK_COUNT];
+
+    RollingAverage gpuTime[GPU_PASS_COUNT];
+    RollingAverage cpuTime[CPU_TASK_COUNT];
+    RollingAverage frameTime;   // seconds
+    RollingAverage samples;     // pixel samples per frame
+    RollingAverage rays;        // rays per frame, < 0 if the backend doesn't count rays
+
+    int    accumulatedSpp;
+    double elapsed;
+    double csvTimer;
+
+    std::ofstream csv;
+
+    mutable std::mutex profileMutex;
+
+public:
+    Profiler();
+    ~Profiler() {}
+
+    void Generate();
+    void GenerateTimer(ProfileGpuPass pass) { gpuTimers[pass].Generate(); }
+
+    void BeginGpu(ProfileGpuPass pass) { gpuTimers[pass].Begin(); }
+    void EndGpu(ProfileGpuPass pass);
+    void SetGpuTime(ProfileGpuPass pass, double milliseconds);
+
+    void BeginCpu(ProfileCpuTask task);
+    void EndCpu(ProfileCpuTask task);
+
+    void EndFrame(float deltaTime, long long frameSamples, long long frameRays, int spp);
+
+    double GetFrameTime() const;
+    double GetGpuTime(ProfileGpuPass pass) const;
+    double GetCpuTime(ProfileCpuTask task) const;
+    double GetSamplesPerSecond() const;
+    double GetMRaysPerSecond() const;
+    int    GetAccumulatedSpp() const;
+
+private:
+    // unlocked versions for EndFrame()
+    double SamplesPerSecond() const;
+    double MRaysPerSecond() const;
+};
+
+Profiler::Profiler() : accumulatedSpp(0), elapsed(0.0), csvTimer(0.0)
+{
+    for (int i = 0; i < GPU_PASS_COUNT; i++)
+        gpuLatest[i] = 0.0;
+    for (int i = 0; i < CPU_TASK_COUNT; i++)
+        cpuLatest[i] = 0.0;
+}
+
+// Opens the CSV, the GPU timers are generated per context with GenerateTimer().
+void Profiler::Generate()
+{
+    if (!Global::ProfileToCsv)
+        return;
+
+    csv.open(Global::ProfilePath);
+    if (!csv.is_open())
+    {
+        std::cout << "ERROR::PROFILER::FILE_NOT_OPENED " << Global::ProfilePath << std::endl;
+        return;
+    }
+
+    csv << "time_s,frame_ms,path_gpu_ms,display_gpu_ms,input_ms,upload_ms,readback_ms,samples_per_s,spp,mrays_per_s" << std::endl;
+}
+
+// Results are read right away, in the context that issued the queries.
+void Profiler::EndGpu(ProfileGpuPass pass)
+{
+    gpuTimers[pass].End();
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    while (gpuTimers[pass].Poll())
+        gpuLatest[pass] = gpuTimers[pass].GetMilliseconds();
+}
+
+void Profiler::SetGpuTime(ProfileGpuPass pass, double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    gpuLatest[pass] = milliseconds;
+}
+
+void Profiler::BeginCpu(ProfileCpuTask task)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    cpuStart[task] = std::chrono::steady_clock::now();
+}
+
+void Profiler::EndCpu(ProfileCpuTask task)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - cpuStart[task];
+    cpuLatest[task] = duration.count();
+}
+
+double Profiler::GetFrameTime() const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return 1000.0 * frameTime.Mean();
+}
+
+double Profiler::GetGpuTime(ProfileGpuPass pass) const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return gpuTime[pass].Mean();
+}
+
+double Profiler::GetCpuTime(ProfileCpuTask task) const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return cpuTime[task].Mean();
+}
+
+double Profiler::GetSamplesPerSecond() const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return SamplesPerSecond();
+}
+
+double Profiler::GetMRaysPerSecond() const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return MRaysPerSecond();
+}
+
+int Profiler::GetAccumulatedSpp() const
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return accumulatedSpp;
+}
+
+double Profiler::SamplesPerSecond() const
+{
+    double seconds = frameTime.Mean();
+    return seconds > 0.0 ? samples.Mean() / seconds : 0.0;
+}
+
+// < 0 if rays are not counted (fragment backend without atomic counters, see RayCounter).
+double Profiler::MRaysPerSecond() const
+{
+    double seconds = frameTime.Mean();
+    double frameRays = rays.Mean();
+    if (frameRays < 0.0)
+        return -1.0;
+    return seconds > 0.0 ? frameRays / seconds / 1.0e6 : 0.0;
+}
+
+void Profiler::EndFrame(float deltaTime, long long frameSamples, long long frameRays, int spp)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    for (int i = 0; i < GPU_PASS_COUNT; i++)
+        gpuTime[i].Add(gpuLatest[i]);
+
+    for (int i = 0; i < CPU_TASK_COUNT; i++)
+        cpuTime[i].Add(cpuLatest[i]);
+
+    frameTime.Add(deltaTime);
+    samples.Add((double)frameSamples);
+    rays.Add((double)frameRays);
+    accumulatedSpp = spp;
+
+    elapsed += deltaTime;
+    csvTimer += deltaTime;
+
+    if (!csv.is_open() || csvTimer < Global::ProfileInterval)
+        return;
+
+    csvTimer = 0.0;
+
+    csv << elapsed << "," << 1000.0 * frameTime.Mean() << ","
+        << gpuTime[GPU_PATH_TRACING].Mean() << "," << gpuTime[GPU_DISPLAY].Mean() << ","
+        << cpuTime[CPU_INPUT].Mean() << "," << cpuTime[CPU_UPLOAD].Mean() << "," << cpuTime[CPU_READBACK].Mean() << ","
+        << SamplesPerSecond() << "," << accumulatedSpp << ",";
+    if (MRaysPerSecond() >= 0.0)
+        csv << MRaysPerSecond();
+    csv << std::endl;
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef RAY_COUNTER_HPP
+#define RAY_COUNTER_HPP
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+#include "Global.hpp"
+
+/* RayCounter
+ * Rays traced on the GPU for the profiler, read back without stalling the pipeline.
+ * Snapshot() copies a GPU counter into the next buffer of a ring of Global::ReadbackRingSize with a fence and resets
+ * the counter, Poll() sums the snapshots whose fence has signaled, so the count of frame N arrives a frame or two late.
+ * SimplePathTracing.fs compiled with COUNT_RAYS counts its rays in an atomic counter at GL_ATOMIC_COUNTER_BUFFER
+ * binding 0, owned by this class (GenerateCounter(), BindCounter()). It needs GL_ARB_shader_atomic_counters and an
+ * OpenGL 4.2 driver, which desktop drivers give the 3.3 core context as well; without them the fragment backend
+ * shows no ray rate. The wavefront backend snapshots RayCount of its CounterBuffer.
+ */
+class RayCounter
+{
+private:
+    unsigned int counterBufferID;    // atomic counter of SimplePathTracing.fs, 0 if not generated
+    unsigned int copyBufferID[Global::ReadbackRingSize];
+    GLsync fence[Global::ReadbackRingSize];
+    int head;
+    int pending;
+
+    long long retired;   // rays of the snapshots retired since the last Poll()
+
+    void Retire(bool block);
+
+    static bool HasExtension(const char *name);
+
+public:
+    RayCounter() : counterBufferID(0), head(0), pending(0), retired(0) {}
+    ~RayCounter() {}
+
+    void Generate();
+    bool GenerateCounter();
+    void BindCounter() const;
+
+    void Snapshot();
+    void Snapshot(unsigned int bufferID, GLintptr offset);
+    long long Poll();
+
+    bool IsCounting() const { return counterBufferID != 0; }
+};
+
+void RayCounter::Generate()
+{
+    const unsigned int zero = 0;
+
+    glGenBuffers(Global::ReadbackRingSize, copyBufferID);
+    for (int i = 0; i < Global::ReadbackRingSize; i++)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, copyBufferID[i]);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(zero), &zero, GL_STREAM_READ);
+        fence[i] = 0;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Atomic counter of SimplePathTracing.fs, false if the driver lacks it: then don't define COUNT_RAYS.
+bool RayCounter::GenerateCounter()
+{
+    if (!GLAD_GL_VERSION_4_2 || !HasExtension("GL_ARB_shader_atomic_counters"))
+        return false;
+
+    const unsigned int zero = 0;
+
+    glGenBuffers(1, &counterBufferID);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBufferID);
+    glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(zero), &zero, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+    return true;
+}
+
+// Indexed bindings are per context, so the thread drawing SimplePathTracing.fs binds it.
+void RayCounter::BindCounter() const
+{
+    if (counterBufferID != 0)
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counterBufferID);
+}
+
+void RayCounter::Snapshot()
+{
+    if (counterBufferID == 0)
+        return;
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    Snapshot(counterBufferID, 0);
+}
+
+// Copies the unsigned int at offset of bufferID and resets it to 0, both in command order on the GPU.
+void RayCounter::Snapshot(unsigned int bufferID, GLintptr offset)
+{
+    if (pending == Global::ReadbackRingSize)
+        Retire(true);
+
+    const unsigned int zero = 0;
+    int slot = (head + pending) % Global::ReadbackRingSize;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, copyBufferID[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, sizeof(zero));
+    glBufferSubData(GL_COPY_READ_BUFFER, offset, sizeof(zero), &zero);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending++;
+}
+
+// Rays of the snapshots completed since the last call.
+long long RayCounter::Poll()
+{
+    while (pending > 0)
+    {
+        GLenum status = glClientWaitSync(fence[head], 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            break;
+        Retire(false);
+    }
+
+    long long rays = retired;
+    retired = 0;
+    return rays;
+}
+
+// Reads the oldest snapshot, its fence has signaled unless block.
+void RayCounter::Retire(bool block)
+{
+    int slot = head;
+
+    if (block)
+        glClientWaitSync(fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+
+    glDeleteSync(fence[slot]);
+    fence[slot] = 0;
+
+    unsigned int rays = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, copyBufferID[slot]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(rays), &rays);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    retired += rays;
+    head = (head + 1) % Global::ReadbackRingSize;
+    pending--;
+}
+
+bool RayCounter::HasExtension(const char *name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (int i = 0; i < count; i++)
+    {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (extension != nullptr && std::strcmp(extension, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+#endif
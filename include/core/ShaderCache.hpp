@@ -0,0 +1,62 @@
+#ifndef SHADER_CACHE_HPP
+#define SHADER_CACHE_HPP
+
+#include <map>
+#include <string>
+
+#include "shader.hpp"
+
+/* ShaderCache
+ * Compiled permutations keyed by their source files and defines.
+ * Every permutation is compiled once, asking for the same files and defines again returns the same program,
+ * so callers can switch between specialized variants (sampler, depth, ...) without recompiling.
+ * Programs live as long as the cache (the GL context is gone by the time static objects are destroyed).
+ */
+class ShaderCache
+{
+private:
+    std::map<std::string, Shader> programs;
+
+    static std::string Key(const std::string &files, const ShaderDefines &defines);
+
+public:
+    ShaderCache() {}
+    ~ShaderCache() {}
+
+    Shader &Get(const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines = ShaderDefines());
+    Shader &GetCompute(const char *computePath, const ShaderDefines &defines = ShaderDefines());
+
+    std::size_t Size() const { return programs.size(); }
+};
+
+std::string ShaderCache::Key(const std::string &files, const ShaderDefines &defines)
+{
+    std::string key = files;
+    for (auto &define : defines)
+        key += "|" + define.first + "=" + define.second;
+    return key;
+}
+
+Shader &ShaderCache::Get(const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines)
+{
+    std::string key = Key(std::string(vertexPath) + "+" + fragmentPath, defines);
+
+    auto it = programs.find(key);
+    if (it == programs.end())
+        it = programs.emplace(key, Shader(vertexPath, fragmentPath, nullptr, defines)).first;
+
+    return it->second;
+}
+
+Shader &ShaderCache::GetCompute(const char *computePath, const ShaderDefines &defines)
+{
+    std::string key = Key(computePath, defines);
+
+    auto it = programs.find(key);
+    if (it == programs.end())
+        it = programs.emplace(key, Shader(computePath, defines)).first;
+
+    return it->second;
+}
+
+#endif
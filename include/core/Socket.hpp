@@ -0,0 +1,253 @@
+#ifndef SOCKET_HPP
+#define SOCKET_HPP
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Socket
+ * Blocking TCP socket over Winsock or BSD sockets, just what TileCoordinator and TileWorker need.
+ * Like the OpenGL objects of the other classes, the handle is released by Close(), not by the destructor,
+ * so sockets can be copied into containers freely.
+ */
+class Socket
+{
+public:
+#ifdef _WIN32
+    typedef SOCKET Handle;
+#else
+    typedef int Handle;
+#endif
+
+private:
+#ifdef _WIN32
+    static constexpr Handle InvalidHandle = INVALID_SOCKET;
+#else
+    static constexpr Handle InvalidHandle = -1;
+#endif
+
+    Handle handle;
+
+public:
+    Socket() : handle(InvalidHandle) {}
+    explicit Socket(Handle handle) : handle(handle) {}
+    ~Socket() {}
+
+    static bool Startup();
+
+    bool Listen(int port);
+    Socket Accept();
+    bool Connect(const std::string &host, int port);
+
+    bool Send(const void *data, size_t size);
+    bool Receive(void *data, size_t size);
+    int  ReceiveSome(void *data, size_t size);
+
+    void Close();
+
+    bool IsValid() const { return handle != InvalidHandle; }
+    Handle GetHandle() const { return handle; }
+
+    static bool WaitReadable(const std::vector<Socket> &sockets, std::vector<bool> &readable, int timeoutMs);
+};
+
+// Once per process before any other call, Winsock has to be initialized.
+bool Socket::Startup()
+{
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        std::cout << "ERROR::SOCKET::WINSOCK_NOT_SUCCESSFULLY_INITIALIZED" << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Listens on every interface.
+bool Socket::Listen(int port)
+{
+    handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == InvalidHandle)
+    {
+        std::cout << "ERROR::SOCKET::NOT_SUCCESSFULLY_CREATED" << std::endl;
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((unsigned short)port);
+
+    if (bind(handle, (sockaddr *)&address, sizeof(address)) != 0 || listen(handle, 16) != 0)
+    {
+        std::cout << "ERROR::SOCKET::PORT_NOT_SUCCESSFULLY_BOUND " << port << std::endl;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+Socket Socket::Accept()
+{
+    Socket client(accept(handle, NULL, NULL));
+
+    // results and requests are small messages answered right away, Nagle would hold them back.
+    int noDelay = 1;
+    if (client.IsValid())
+        setsockopt(client.handle, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+
+    return client;
+}
+
+bool Socket::Connect(const std::string &host, int port)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo *addresses = NULL;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+    {
+        std::cout << "ERROR::SOCKET::HOST_NOT_FOUND " << host << std::endl;
+        return false;
+    }
+
+    for (addrinfo *address = addresses; address != NULL; address = address->ai_next)
+    {
+        handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (handle == InvalidHandle)
+            continue;
+        if (connect(handle, address->ai_addr, (int)address->ai_addrlen) == 0)
+            break;
+        Close();
+    }
+
+    freeaddrinfo(addresses);
+
+    if (!IsValid())
+    {
+        std::cout << "ERROR::SOCKET::NOT_SUCCESSFULLY_CONNECTED " << host << ":" << port << std::endl;
+        return false;
+    }
+
+    int noDelay = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+    return true;
+}
+
+// All of data, false if the connection broke.
+bool Socket::Send(const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+
+    while (size > 0)
+    {
+#ifdef MSG_NOSIGNAL
+        int sent = send(handle, bytes, (int)size, MSG_NOSIGNAL);   // a closed peer mustn't kill the process with SIGPIPE
+#else
+        int sent = send(handle, bytes, (int)size, 0);
+#endif
+        if (sent <= 0)
+            return false;
+
+        bytes += sent;
+        size -= sent;
+    }
+
+    return true;
+}
+
+// All of data, false if the connection broke or closed first.
+bool Socket::Receive(void *data, size_t size)
+{
+    char *bytes = (char *)data;
+
+    while (size > 0)
+    {
+        int received = ReceiveSome(bytes, size);
+        if (received <= 0)
+            return false;
+
+        bytes += received;
+        size -= received;
+    }
+
+    return true;
+}
+
+// Whatever arrived, at most size bytes. 0 if the peer closed the connection, < 0 on errors.
+int Socket::ReceiveSome(void *data, size_t size)
+{
+    return (int)recv(handle, (char *)data, (int)size, 0);
+}
+
+void Socket::Close()
+{
+    if (!IsValid())
+        return;
+
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    close(handle);
+#endif
+    handle = InvalidHandle;
+}
+
+// readable[i]: sockets[i] has data or a connection to accept, or was closed. False if nothing happened in time.
+bool Socket::WaitReadable(const std::vector<Socket> &sockets, std::vector<bool> &readable, int timeoutMs)
+{
+    fd_set set;
+    FD_ZERO(&set);
+
+    Handle maxHandle = 0;
+    for (const Socket &each : sockets)
+    {
+        FD_SET(each.handle, &set);
+        maxHandle = std::max(maxHandle, each.handle);
+    }
+
+    timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    // the first argument is ignored by Winsock.
+    int count = select((int)maxHandle + 1, &set, NULL, NULL, &timeout);
+
+    readable.assign(sockets.size(), false);
+    if (count <= 0)
+        return false;
+
+    for (size_t i = 0; i < sockets.size(); i++)
+        readable[i] = FD_ISSET(sockets[i].handle, &set) != 0;
+
+    return true;
+}
+
+#endif
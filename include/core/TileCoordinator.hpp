@@ -0,0 +1,375 @@
+#ifndef TILE_COORDINATOR_HPP
+#define TILE_COORDINATOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "Global.hpp"
+#include "BatchRenderer.hpp"
+#include "ModelData.hpp"
+#include "Options.hpp"
+#include "Socket.hpp"
+
+// Messages between TileCoordinator and TileWorker, a MessageHeader followed by size bytes of payload.
+enum MessageType : uint32_t
+{
+    MESSAGE_REQUEST,   // worker     : ready for a tile
+    MESSAGE_SCENE,     // coordinator: SceneHeader, model data, material data, once after connecting
+    MESSAGE_TILE,      // coordinator: TileRect to render
+    MESSAGE_DONE,      // coordinator: every tile arrived, disconnect
+    MESSAGE_RESULT     // worker     : TileRect, RGBA floats of the tile's accumulation, bottom row first
+};
+
+struct MessageHeader
+{
+    uint32_t type;
+    uint32_t size;
+};
+
+struct SceneHeader
+{
+    RenderSettings settings;
+    int samples;         // per pixel of every tile
+    float lightArea;     // ModelData::GetLightArea()
+    int modelSize;       // floats of ModelData::GetModelData()
+    int materialSize;    // floats of ModelData::GetMaterialData()
+};
+
+struct TileRect
+{
+    int id;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Sends a message whose payload are the given parts, false if the connection broke.
+bool WriteMessage(Socket &socket, MessageType type, const void *first = NULL, size_t firstSize = 0,
+                  const void *second = NULL, size_t secondSize = 0, const void *third = NULL, size_t thirdSize = 0)
+{
+    MessageHeader header = { type, (uint32_t)(firstSize + secondSize + thirdSize) };
+
+    return socket.Send(&header, sizeof(header)) &&
+           socket.Send(first, firstSize) && socket.Send(second, secondSize) && socket.Send(third, thirdSize);
+}
+
+/* TileCoordinator
+ * Distributed headless render (--coordinator PORT): hands the image to TileWorker processes one Global::TileSize tile
+ * at a time and assembles the float accumulations they send back. It traces nothing itself.
+ * Workers get the scene's model and material data with the first message, so they need neither the model files
+ * nor the coordinator's file system. Messages are in host byte order, the machines of a render farm share it.
+ * Work stealing: once no tile is pending, an idle worker gets the tile that has been rendering longest on
+ * another worker (at most Global::MaxTileCopies copies at a time), whichever result arrives first is kept.
+ * The tile of a worker whose connection closes is pending again.
+ * Samples only depend on the pixel and the sample index, so the assembled image is the one of a local headless render.
+ */
+class TileCoordinator
+{
+private:
+    enum TileState { TILE_PENDING, TILE_RENDERING, TILE_DONE };
+
+    struct Tile
+    {
+        TileRect rect;
+        TileState state;
+        int copies;   // workers rendering it
+        std::chrono::steady_clock::time_point started;
+    };
+
+    struct Connection
+    {
+        Socket socket;
+        std::vector<char> buffer;   // received bytes of incomplete messages
+        int tile;                   // -1 if idle
+        bool isWaiting;             // requested a tile while none was available
+        int tilesDone;
+    };
+
+    const Options &options;
+    const ModelData &modelData;
+
+    Socket listener;
+    std::vector<Tile> tiles;
+    std::vector<Connection> connections;
+    std::vector<float> pixels;   // RGBA accumulation of the whole image
+
+    int tilesDone;
+    int stolenTiles;
+    int lostWorkers;
+
+    void Accept();
+    bool Process(Connection &connection);
+    bool Handle(Connection &connection, const MessageHeader &header, const char *payload);
+    void Assign(Connection &connection);
+    void Release(Connection &connection);
+
+public:
+    TileCoordinator(const Options &options, const ModelData &modelData);
+    ~TileCoordinator() {}
+
+    bool Run();
+
+    const std::vector<float> &GetPixels() const { return pixels; }
+};
+
+TileCoordinator::TileCoordinator(const Options &options, const ModelData &modelData)
+    : options(options), modelData(modelData), pixels(4 * Global::PixelCount, 0.0f), tilesDone(0), stolenTiles(0), lostWorkers(0)
+{
+    for (int y = 0; y < (int)Global::WindowHeight; y += Global::TileSize)
+        for (int x = 0; x < (int)Global::WindowWidth; x += Global::TileSize)
+        {
+            Tile tile;
+            tile.rect = { (int)tiles.size(), x, y, std::min(Global::TileSize, (int)Global::WindowWidth - x),
+                          std::min(Global::TileSize, (int)Global::WindowHeight - y) };
+            tile.state = TILE_PENDING;
+            tile.copies = 0;
+            tiles.push_back(tile);
+        }
+}
+
+// Serves workers until every tile arrived, false if the port couldn't be opened.
+bool TileCoordinator::Run()
+{
+    if (!Socket::Startup() || !listener.Listen(options.coordinatorPort))
+        return false;
+
+    std::cout << "Coordinating " << tiles.size() << " tiles of " << options.samples << " spp on port " << options.coordinatorPort << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    double lastProgress = 0.0;
+
+    while (tilesDone < (int)tiles.size())
+    {
+        std::vector<Socket> sockets(1, listener);
+        for (Connection &connection : connections)
+            sockets.push_back(connection.socket);
+
+        std::vector<bool> readable;
+        if (Socket::WaitReadable(sockets, readable, 100))
+        {
+            // backwards, a closed connection is erased right away.
+            for (int i = (int)connections.size() - 1; i >= 0; i--)
+            {
+                if (!readable[i + 1] || Process(connections[i]))
+                    continue;
+
+                if (connections[i].tile >= 0 && tiles[connections[i].tile].state != TILE_DONE)
+                    lostWorkers++;
+
+                Release(connections[i]);
+                connections[i].socket.Close();
+                connections.erase(connections.begin() + i);
+            }
+
+            if (readable[0])
+                Accept();
+        }
+
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time - lastProgress >= Global::BatchProgressInterval)
+        {
+            std::cout << "\rTiles " << tilesDone << " / " << tiles.size() << ", " << connections.size() << " workers    " << std::flush;
+            lastProgress = time;
+        }
+    }
+
+    for (Connection &connection : connections)
+    {
+        WriteMessage(connection.socket, MESSAGE_DONE);
+        connection.socket.Close();
+    }
+    listener.Close();
+
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\rRendered " << tiles.size() << " tiles in " << time << " s, " << stolenTiles << " stolen, "
+              << lostWorkers << " workers lost." << std::endl;
+
+    return true;
+}
+
+// A new worker gets the scene right away, it requests its first tile once it's set up.
+void TileCoordinator::Accept()
+{
+    Connection connection;
+    connection.socket = listener.Accept();
+    connection.tile = -1;
+    connection.isWaiting = false;
+    connection.tilesDone = 0;
+
+    if (!connection.socket.IsValid())
+        return;
+
+    const std::vector<float> &model = modelData.GetModelData();
+    const std::vector<float> &material = modelData.GetMaterialData();
+
+    SceneHeader scene;
+    scene.settings = RenderSettings::Current(options.samples);
+    scene.samples = options.samples;
+    scene.lightArea = modelData.GetLightArea();
+    scene.modelSize = (int)model.size();
+    scene.materialSize = (int)material.size();
+
+    if (!WriteMessage(connection.socket, MESSAGE_SCENE, &scene, sizeof(scene),
+                      model.data(), model.size() * sizeof(float), material.data(), material.size() * sizeof(float)))
+    {
+        connection.socket.Close();
+        return;
+    }
+
+    connections.push_back(connection);
+}
+
+// Reads what arrived and handles every complete message, false once the connection closed or misbehaved.
+bool TileCoordinator::Process(Connection &connection)
+{
+    char chunk[65536];
+    int received = connection.socket.ReceiveSome(chunk, sizeof(chunk));
+    if (received <= 0)
+        return false;
+
+    connection.buffer.insert(connection.buffer.end(), chunk, chunk + received);
+
+    size_t offset = 0;
+    while (connection.buffer.size() - offset >= sizeof(MessageHeader))
+    {
+        MessageHeader header;
+        std::memcpy(&header, connection.buffer.data() + offset, sizeof(header));
+
+        // anyone can connect: a header a worker can't send is rejected before its payload is buffered.
+        const size_t maxSize = sizeof(TileRect) + 4 * (size_t)Global::TileSize * Global::TileSize * sizeof(float);
+        if ((header.type != MESSAGE_REQUEST && header.type != MESSAGE_RESULT) || header.size > maxSize)
+        {
+            std::cout << "ERROR::TILE_COORDINATOR::INVALID_MESSAGE " << header.type << " " << header.size << std::endl;
+            return false;
+        }
+
+        if (connection.buffer.size() - offset - sizeof(header) < header.size)
+            break;
+
+        if (!Handle(connection, header, connection.buffer.data() + offset + sizeof(header)))
+            return false;
+
+        offset += sizeof(header) + header.size;
+    }
+
+    connection.buffer.erase(connection.buffer.begin(), connection.buffer.begin() + offset);
+    return true;
+}
+
+bool TileCoordinator::Handle(Connection &connection, const MessageHeader &header, const char *payload)
+{
+    if (header.type == MESSAGE_REQUEST)
+    {
+        Assign(connection);
+        return true;
+    }
+
+    if (header.type != MESSAGE_RESULT || header.size < sizeof(TileRect))
+    {
+        std::cout << "ERROR::TILE_COORDINATOR::UNEXPECTED_MESSAGE " << header.type << std::endl;
+        return false;
+    }
+
+    TileRect rect;
+    std::memcpy(&rect, payload, sizeof(rect));
+
+    // anyone can connect: the id is checked before indexing, the size only against the tile that was sent out.
+    bool isValid = connection.tile >= 0 && rect.id == connection.tile && rect.id < (int)tiles.size() &&
+                   std::memcmp(&rect, &tiles[rect.id].rect, sizeof(rect)) == 0;
+    if (!isValid || header.size != sizeof(TileRect) + 4 * (size_t)rect.width * (size_t)rect.height * sizeof(float))
+    {
+        std::cout << "ERROR::TILE_COORDINATOR::INVALID_RESULT " << rect.id << std::endl;
+        return false;
+    }
+
+    Tile &tile = tiles[rect.id];
+    tile.copies--;
+    connection.tile = -1;
+    connection.tilesDone++;
+
+    // a stolen tile arrives twice, the first result is kept.
+    if (tile.state == TILE_DONE)
+        return true;
+
+    const char *data = payload + sizeof(TileRect);
+    for (int row = 0; row < rect.height; row++)
+        std::memcpy(&pixels[4 * ((rect.y + row) * Global::WindowWidth + rect.x)],
+                    data + 4 * row * rect.width * sizeof(float), 4 * rect.width * sizeof(float));
+
+    tile.state = TILE_DONE;
+    tilesDone++;
+    return true;
+}
+
+// Next pending tile, or the longest rendering one of another worker.
+void TileCoordinator::Assign(Connection &connection)
+{
+    int chosen = -1;
+
+    for (Tile &tile : tiles)
+        if (tile.state == TILE_PENDING)
+        {
+            chosen = tile.rect.id;
+            break;
+        }
+
+    if (chosen < 0)
+    {
+        for (Tile &tile : tiles)
+            if (tile.state == TILE_RENDERING && tile.copies < Global::MaxTileCopies &&
+                (chosen < 0 || tile.started < tiles[chosen].started))
+                chosen = tile.rect.id;
+
+        if (chosen >= 0)
+            stolenTiles++;
+    }
+
+    if (chosen < 0)
+    {
+        connection.isWaiting = true;
+        return;
+    }
+
+    Tile &tile = tiles[chosen];
+    if (tile.state == TILE_PENDING)
+        tile.started = std::chrono::steady_clock::now();
+    tile.state = TILE_RENDERING;
+    tile.copies++;
+
+    connection.tile = chosen;
+    connection.isWaiting = false;
+
+    WriteMessage(connection.socket, MESSAGE_TILE, &tile.rect, sizeof(tile.rect));
+}
+
+// The connection closed: its tile is pending again unless another worker still renders it,
+// either way a waiting worker can take it over.
+void TileCoordinator::Release(Connection &connection)
+{
+    if (connection.tile < 0)
+        return;
+
+    Tile &tile = tiles[connection.tile];
+    tile.copies--;
+    connection.tile = -1;
+
+    if (tile.state == TILE_DONE)
+        return;
+
+    if (tile.copies == 0)
+        tile.state = TILE_PENDING;
+
+    for (Connection &waiting : connections)
+        if (waiting.isWaiting && &waiting != &connection)
+        {
+            Assign(waiting);
+            break;
+        }
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef TILE_SCHEDULER_HPP
+#define TILE_SCHEDULER_HPP
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+
+#include "Global.hpp"
+#include "GpuTimer.hpp"
+
+/* TileScheduler
+ * Splits a pass (samples of the whole image) into Global::TileSize tiles and renders only as many tiles per frame
+ * as fit into Global::TileTimeBudget, so a long path tracing draw never blocks the GPU (and the window) for seconds.
+ * The other way round, a pass that takes less than the budget gets several samples per pixel (GetPassSamples()),
+ * up to Global::MaxSamplesPerPass, so the per frame overhead is paid once for all of them.
+ * Work is measured in tile samples: the budget follows the GPU time of earlier batches measured with a GpuTimer.
+ * The accumulation must only be swapped once a pass is complete, see Render().
+ */
+class TileScheduler
+{
+private:
+    const int tilesX;
+    const int tilesY;
+    const int tileCount;
+
+    int   nextTile;        // first tile of the next batch, tiles are visited row by row
+    float tilesPerFrame;   // tile samples, adapted to the time budget
+    int   passSamples;     // samples per pixel of the current pass, fixed until it completes
+
+    GpuTimer timer;
+    std::deque<int> timedBatches;   // tile samples of every batch whose timer result is pending
+
+    void Adapt();
+    void CompletePass();
+
+public:
+    TileScheduler();
+    ~TileScheduler() {}
+
+    void Generate();
+
+    bool Render(const std::function<void()> &draw, int samples);
+    void RenderWhole(const std::function<void()> &draw, int samples);
+    void Restart();
+
+    int   GetTileCount() const { return tileCount; }
+    float GetTilesPerFrame() const { return tilesPerFrame; }
+    float GetBudgetPixels() const { return tilesPerFrame * Global::TileSize * Global::TileSize; }   // 1 spp within the budget
+    int   GetPassSamples() const { return passSamples; }
+    double GetGpuTime() const { return timer.GetMilliseconds(); }   // latest timed batch, ms
+};
+
+TileScheduler::TileScheduler()
+    : tilesX((Global::WindowWidth + Global::TileSize - 1) / Global::TileSize),
+      tilesY((Global::WindowHeight + Global::TileSize - 1) / Global::TileSize),
+      tileCount(tilesX * tilesY),
+      nextTile(0),
+      tilesPerFrame((float)tilesX), // one row until the first measurement arrives
+      passSamples(1)
+{
+}
+
+void TileScheduler::Generate()
+{
+    timer.Generate();
+}
+
+// Per tile sample cost of the finished batches, smoothed so a single slow frame doesn't halve the throughput.
+void TileScheduler::Adapt()
+{
+    while (timer.Poll())
+    {
+        int tileSamples = timedBatches.front();
+        timedBatches.pop_front();
+
+        double perTileSample = timer.GetMilliseconds() / tileSamples;
+        if (perTileSample <= 0.0)
+            continue;
+
+        float target = (float)(Global::TileTimeBudget / perTileSample);
+        float maxTileSamples = (float)(tileCount * Global::MaxSamplesPerPass);
+        tilesPerFrame = Global::clamp(1.0f, maxTileSamples, 0.5f * tilesPerFrame + 0.5f * target);
+    }
+}
+
+// Samples of the next pass: as many whole passes as fit into a frame.
+void TileScheduler::CompletePass()
+{
+    nextTile = 0;
+    passSamples = std::max(1, std::min(Global::MaxSamplesPerPass, (int)(tilesPerFrame / tileCount)));
+}
+
+// The accumulation restarted, the next pass starts at the first tile.
+void TileScheduler::Restart()
+{
+    CompletePass();
+}
+
+// Draws the next batch of tiles into the bound framebuffer with the scissor test.
+// samples: per pixel of every draw, the same for all batches of a pass, GetPassSamples() for interactive passes.
+// Returns true when the batch completed a pass, i.e. every pixel received its samples.
+bool TileScheduler::Render(const std::function<void()> &draw, int samples)
+{
+    if (!Global::TiledRendering)
+    {
+        RenderWhole(draw, samples);
+        return true;
+    }
+
+    Adapt();
+
+    int batch = std::min(std::max(1, (int)(tilesPerFrame / samples)), tileCount - nextTile);
+
+    glEnable(GL_SCISSOR_TEST);
+
+    if (timer.Begin())
+        timedBatches.push_back(batch * samples);
+
+    for (int tile = nextTile; tile < nextTile + batch; tile++)
+    {
+        glScissor((tile % tilesX) * Global::TileSize, (tile / tilesX) * Global::TileSize, Global::TileSize, Global::TileSize);
+        draw();
+    }
+
+    timer.End();
+
+    glDisable(GL_SCISSOR_TEST);
+
+    nextTile += batch;
+    if (nextTile < tileCount)
+        return false;
+
+    CompletePass();
+    return true;
+}
+
+// A complete pass in one go, for draws that can't be split into tiles (the wavefront backend).
+// Timed like a batch of every tile, so it also adapts GetPassSamples().
+void TileScheduler::RenderWhole(const std::function<void()> &draw, int samples)
+{
+    Adapt();
+
+    if (timer.Begin())
+        timedBatches.push_back(tileCount * samples);
+
+    draw();
+
+    timer.End();
+
+    CompletePass();
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef TILE_WORKER_HPP
+#define TILE_WORKER_HPP
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "BatchRenderer.hpp"
+#include "ModelData.hpp"
+#include "Socket.hpp"
+#include "TileCoordinator.hpp"
+
+/* TileWorker
+ * Other end of TileCoordinator (--worker HOST:PORT): receives the scene once, then requests tiles, renders them
+ * and sends their float accumulation back until the coordinator is done. A worker may join or leave at any time.
+ * Tiles are drawn with the scissor test, so only the fragment backend can render them.
+ */
+class TileWorker
+{
+private:
+    Socket socket;
+    SceneHeader scene;
+
+    std::vector<float> pixels;   // RGBA accumulation of the current tile
+
+public:
+    TileWorker() {}
+    ~TileWorker() {}
+
+    bool Connect(const std::string &address);
+    bool ReceiveScene(ModelData &modelData);
+
+    int Run(const std::function<void(const TileRect &tile, std::vector<float> &pixels)> &renderTile);
+
+    int GetSamples() const { return scene.samples; }
+};
+
+// address: HOST:PORT of the coordinator.
+bool TileWorker::Connect(const std::string &address)
+{
+    if (Global::Backend != Global::FRAGMENT)
+    {
+        std::cout << "ERROR::TILE_WORKER::FRAGMENT_BACKEND_ONLY" << std::endl;
+        return false;
+    }
+
+    size_t colon = address.find_last_of(':');
+    if (colon == std::string::npos)
+    {
+        std::cout << "ERROR::TILE_WORKER::INVALID_ADDRESS " << address << " expected HOST:PORT" << std::endl;
+        return false;
+    }
+
+    return Socket::Startup() && socket.Connect(address.substr(0, colon), std::atoi(address.c_str() + colon + 1));
+}
+
+// Scene textures from the coordinator's data, instead of loading the model files.
+bool TileWorker::ReceiveScene(ModelData &modelData)
+{
+    MessageHeader header;
+    if (!socket.Receive(&header, sizeof(header)) || header.type != MESSAGE_SCENE || header.size < sizeof(SceneHeader) ||
+        !socket.Receive(&scene, sizeof(scene)))
+    {
+        std::cout << "ERROR::TILE_WORKER::SCENE_NOT_SUCCESSFULLY_RECEIVED" << std::endl;
+        return false;
+    }
+
+    std::vector<float> model(scene.modelSize);
+    std::vector<float> material(scene.materialSize);
+
+    if (header.size != sizeof(SceneHeader) + (model.size() + material.size()) * sizeof(float) ||
+        !socket.Receive(model.data(), model.size() * sizeof(float)) ||
+        !socket.Receive(material.data(), material.size() * sizeof(float)))
+    {
+        std::cout << "ERROR::TILE_WORKER::SCENE_NOT_SUCCESSFULLY_RECEIVED" << std::endl;
+        return false;
+    }
+
+    // resolution, sampler and the like are compiled in, both sides have to be built alike.
+    if (!(scene.settings == RenderSettings::Current(scene.samples)))
+    {
+        std::cout << "ERROR::TILE_WORKER::SETTINGS_MISMATCH the coordinator was built with other Global settings" << std::endl;
+        return false;
+    }
+
+    modelData.GenerateTextures(model, material, scene.lightArea);
+    return true;
+}
+
+// Renders tiles until the coordinator is done or the connection breaks, returns the number of tiles sent.
+int TileWorker::Run(const std::function<void(const TileRect &tile, std::vector<float> &pixels)> &renderTile)
+{
+    int tileCount = 0;
+
+    while (WriteMessage(socket, MESSAGE_REQUEST))
+    {
+        MessageHeader header;
+        TileRect tile;
+
+        if (!socket.Receive(&header, sizeof(header)) || header.type == MESSAGE_DONE)
+            break;
+
+        if (header.type != MESSAGE_TILE || header.size != sizeof(tile) || !socket.Receive(&tile, sizeof(tile)))
+        {
+            std::cout << "ERROR::TILE_WORKER::UNEXPECTED_MESSAGE " << header.type << std::endl;
+            break;
+        }
+
+        // the tile is read back from this process' window sized accumulation.
+        if (tile.x < 0 || tile.y < 0 || tile.width <= 0 || tile.height <= 0 ||
+            tile.width > (int)Global::WindowWidth - tile.x || tile.height > (int)Global::WindowHeight - tile.y)
+        {
+            std::cout << "ERROR::TILE_WORKER::INVALID_TILE " << tile.id << std::endl;
+            break;
+        }
+
+        renderTile(tile, pixels);
+
+        if (!WriteMessage(socket, MESSAGE_RESULT, &tile, sizeof(tile), pixels.data(), pixels.size() * sizeof(float)))
+            break;
+
+        tileCount++;
+    }
+
+    socket.Close();
+    return tileCount;
+}
+
+#endif
@@ -11,27 +11,55 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stbi/stb_image.hpp>
+#include <atomic>
 #include <iostream>
-#include <tuple>
+#include <mutex>
 
 #include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "AovBuffer.hpp"
+#include "BatchRenderer.hpp"
+#include "Benchmark.hpp"
+#include "BlueNoise.hpp"
 #include "Camera.hpp"
+#include "Checkpoint.hpp"
 #include "CornellBox.hpp"
+#include "Denoiser.hpp"
+#include "DynamicResolution.hpp"
 #include "FrameSaver.hpp"
+#include "HeadlessContext.hpp"
+#include "Hud.hpp"
 #include "Model.hpp"
 #include "ModelData.hpp"
+#include "Options.hpp"
+#include "PartialAccumulation.hpp"
+#include "PresentBuffer.hpp"
+#include "Profiler.hpp"
+#include "RayCounter.hpp"
 #include "shader.hpp"
+#include "TileScheduler.hpp"
+#include "TileCoordinator.hpp"
+#include "TileWorker.hpp"
+#include "ShaderCache.hpp"
+#include "Wavefront.hpp"
 
 namespace Utility
 {
 	// Variables-------------------------------------------------------------------
 
-	// camera
+	// camera, changed by input on the main thread and read by the render thread (Global::ThreadedRendering)
 	Camera camera(Global::CameraPos, Global::WorldFront, Global::WorldLeft);
+	std::mutex cameraMutex;
 
 	// frame saver
 	FrameSaver image;
 
+	// float accumulation of samples on the GPU
+	AccumulationBuffer accumulation;
+
+	// AOVs of the saved image, see Global::RenderAOVs
+	AovBuffer aovs;
+
 	// coords and time
 	float lastX = Global::WindowWidth / 2.0f;
 	float lastY = Global::WindowHeight / 2.0f;
@@ -40,8 +68,18 @@ namespace Utility
 	float deltaTime = 0.0f;
 	float lastFrame = 0.0f;
 
+	float savingTime = 0.0f;   // frame time statistics, idle versus saving
+	float idleTime = 0.0f;
+	float savingMaxTime = 0.0f; // slowest saving frame, a synchronous readback shows up here rather than in the average
+	int savingFrames = 0;
+	int idleFrames = 0;
+
+	int framebufferWidth = Global::WindowWidth;
+	int framebufferHeight = Global::WindowHeight;
+
 	// flags
-	int isSave = Global::spp;
+	int isSave = Global::spp;   // != Global::spp while Global::spp samples are being accumulated for saving
+	std::atomic<bool> saveRequested(false);   // Ctrl+S, handled by ProcessSaveRequest() where the accumulation lives
 
 	// Function Declaration--------------------------------------------------------
 
@@ -50,20 +88,26 @@ namespace Utility
 
 	GLFWwindow *InitGlfwAndCreateWindow();
 
+	GLFWwindow *CreateSharedContext(GLFWwindow *window);
+
 	bool SetCallback(GLFWwindow *window);
 
 	bool InitGlad();
 
-	std::tuple<unsigned int, unsigned int> SetVAOVBO(float *vertices);
-
 	void PathTracingShaderSetup(Shader &shader);
 
+	ShaderDefines PathTracingDefines(const ModelData &modelData);
+
 	// Process and Callbacks
 	void ProcessInput(GLFWwindow *window);
 
 	void ProcessTime();
 
-	void PostProcess();
+	bool IsSaving();
+
+	bool ProcessSaveRequest();
+
+	void PostProcess(float frameTime);
 
 	void FramebufferSizeCallback(GLFWwindow *window, int width, int height);
 
@@ -100,7 +144,7 @@ namespace Utility
 	GLFWwindow *InitGlfwAndCreateWindow()
 	{
 		glfwInit();
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, Global::Backend == Global::WAVEFRONT ? 4 : 3);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -120,6 +164,21 @@ namespace Utility
 		return window;
 	}
 
+	// Invisible window whose context shares objects with window's, for the render thread.
+	GLFWwindow *CreateSharedContext(GLFWwindow *window)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+		GLFWwindow *shared = glfwCreateWindow(1, 1, Global::WindowName.c_str(), NULL, window);
+
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+		if (shared == NULL)
+			std::cout << "Failed to create shared GLFW context" << std::endl;
+
+		return shared;
+	}
+
 	bool SetCallback(GLFWwindow *window)
 	{
 		glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
@@ -140,24 +199,51 @@ namespace Utility
 			return true;
 	}
 
-	std::tuple<unsigned int, unsigned int> SetVAOVBO(float *vertices)
+	// Uniforms shared by every path tracing program: SimplePathTracing.fs and the Wavefront*.cs stages.
+	void PathTracingShaderSetup(Shader &shader)
+	{
+		shader.use();
+		shader.setArray("DefaultMat", 12, const_cast<float *>(Global::DefaultMat));
+		shader.setInt("TriData", 0);
+		shader.setInt("MatData", 1);
+		shader.setInt("BlueNoise", 2);
+		shader.setInt("Accumulation", 3);
+		shader.setInt("PreviousDepth", 4);
+		shader.setInt("Moments", 5);
+		shader.setInt("DirectAccumulation", 9);
+		shader.setBool("RenderAOVs", accumulation.HasAovs());
+		shader.setBool("AdaptiveSampling", Global::AdaptiveSampling);
+		shader.setFloat("AdaptiveThreshold", Global::AdaptiveThreshold);
+		shader.setInt("AdaptiveMinSamples", Global::AdaptiveMinSamples);
+		shader.setInt("ReprojectionHistory", Global::ReprojectionHistory);
+		shader.setFloat("ReprojectionTolerance", Global::ReprojectionTolerance);
+		shader.setBlockBinding("CameraBlock", Global::CameraBlockBinding);
+		shader.setInt("SamplerType", Global::Sampler);
+		shader.setInt("SampleCount", Global::spp);
+		shader.setInt("BlueNoiseDimensions", Global::BlueNoiseDimensions);
+		shader.setInt("spp", 1); // set per pass, see TileScheduler::GetPassSamples()
+		shader.setInt("MaxDepth", Global::MaxDepth);
+		shader.setInt("RussianRouletteDepth", Global::RussianRouletteDepth);
+		shader.setFloat("IndirLightContriRate", Global::IndirLightContributionRate);
+	}
+
+	// Compile time constants of the path tracing programs, see the permutation block in PathTracingCommon.glsl.
+	ShaderDefines PathTracingDefines(const ModelData &modelData)
 	{
-		unsigned int VAO;
-		unsigned int VBO;
+		ShaderDefines defines;
 
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
+		if (!Global::SpecializeShaders)
+			return defines;
 
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, Global::WindowHeight * Global::WindowWidth * sizeof(float) * 5, vertices, GL_STATIC_DRAW);
+		std::ostringstream lightArea;
+		lightArea << std::showpoint << std::setprecision(9) << modelData.GetLightArea();
 
-		glBindVertexArray(VAO);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
+		defines["MAX_DEPTH"] = std::to_string(Global::MaxDepth);
+		defines["RUSSIAN_ROULETTE_DEPTH"] = std::to_string(Global::RussianRouletteDepth);
+		defines["SAMPLER_TYPE"] = std::to_string(Global::Sampler);
+		defines["LIGHT_AREA"] = lightArea.str();
 
-		return std::tuple<unsigned int, unsigned int>{VAO, VBO};
+		return defines;
 	}
 
 	// Process and Callbacks
@@ -170,10 +256,12 @@ namespace Utility
 		// left-CTRL + S
 		if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS && glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
 		{
-			isSave = 0;
+			saveRequested = true;
 			return;
 		}
 
+		std::lock_guard<std::mutex> lock(cameraMutex);
+
 		// W
 		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 			camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -198,14 +286,81 @@ namespace Utility
 		lastFrame = currentFrame;
 	}
 
-	void PostProcess()
+	bool IsSaving()
+	{
+		return isSave != Global::spp;
+	}
+
+	// Returns true if the accumulation restarted.
+	bool ProcessSaveRequest()
 	{
-		if (isSave != Global::spp)
-			isSave = image.SaveBuffer();
+		if (!saveRequested.exchange(false))
+			return false;
+
+		bool isRestart = !IsSaving();
+		if (isRestart)
+			accumulation.Reset();
+		isSave = 0;
+
+		return isRestart;
+	}
+
+	// The accumulation is read back asynchronously when Global::spp samples are complete
+	// (and every Global::SnapshotInterval samples for progress images).
+	// frameTime: seconds of the frame (render thread iteration) that produced the latest samples.
+	void PostProcess(float frameTime)
+	{
+		image.ProcessReadbacks(false);
+
+		if (!IsSaving())
+		{
+			idleTime += frameTime;
+			idleFrames++;
+			return;
+		}
+
+		savingTime += frameTime;
+		savingMaxTime = std::max(savingMaxTime, frameTime);
+		savingFrames++;
+
+		int samples = accumulation.GetSampleCount();
+		bool isComplete = samples >= Global::spp;
+		bool isNewSample = samples != isSave; // a tiled pass takes several frames to add a sample
+		// a pass may add several samples and step over a multiple of the interval.
+		bool isSnapshot = Global::SnapshotInterval > 0 && samples / Global::SnapshotInterval != isSave / Global::SnapshotInterval;
+
+		if (isNewSample && (isComplete || isSnapshot))
+		{
+			accumulation.BindReadBuffer();
+			image.RequestReadback(samples, isComplete);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		}
+
+		if (!isComplete)
+		{
+			isSave = samples;
+			return;
+		}
+
+		// first hit features and direct lighting of the same samples, read back once.
+		if (accumulation.HasAovs())
+		{
+			aovs.ReadBack(accumulation);
+			aovs.Write(Global::ImageName.substr(0, Global::ImageName.find_last_of('.')));
+		}
+
+		std::cout << "Saved " << samples << " spp. Average frame time: "
+				  << 1000.0f * idleTime / std::max(idleFrames, 1) << " ms idle, "
+				  << 1000.0f * savingTime / std::max(savingFrames, 1) << " ms saving, "
+				  << 1000.0f * savingMaxTime << " ms slowest saving frame." << std::endl;
+
+		isSave = Global::spp;
 	}
 
 	void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 	{
+		framebufferWidth = width;
+		framebufferHeight = height;
 		glViewport(0, 0, width, height);
 	}
 
@@ -224,6 +379,7 @@ namespace Utility
 		lastX = xpos;
 		lastY = ypos;
 
+		std::lock_guard<std::mutex> lock(cameraMutex);
 		camera.ProcessMouseMovement(xoffset, yoffset);
 	}
 
@@ -0,0 +1,211 @@
+#ifndef WAVEFRONT_HPP
+#define WAVEFRONT_HPP
+
+#include <glad/glad.h>
+
+#include <functional>
+
+#include "Global.hpp"
+#include "AccumulationBuffer.hpp"
+#include "RayCounter.hpp"
+#include "shader.hpp"
+#include "ShaderCache.hpp"
+
+/* WavefrontPathTracer
+ * Compute shader backend (Laine et al., "Megakernels Considered Harmful", 2013).
+ * Instead of one fragment shader looping over a whole path, every bounce runs four small stages:
+ *     Prepare : paths pushed by the last stage become the input queue, writes the indirect dispatch size
+ *     Extend  : closest hit of every queued path
+ *     Shade   : emission, light sample pushed to the shadow queue, surviving paths pushed to the output queue
+ *     Connect : visibility of the light samples
+ * Queues are compacted with atomicAdd on the counters in CounterBuffer, so finished paths stop occupying threads.
+ * Prepare also sums the traced rays into CounterBuffer.RayCount, a RayCounter snapshots it after every Render().
+ * Generate skips the pixels IsConverged() in PathTracingCommon.glsl, Accumulate carries their accumulation over.
+ * The scene, material, blue-noise, accumulation and moment textures are the ones bound for SimplePathTracing.fs.
+ * Shade writes the Denoiser's features at camera hits, pixels Generate skips keep those of their last pass.
+ * Shade and Connect also sum the direct lighting of every path into DirectBuffer, Accumulate adds it to the
+ * accumulation's direct texture when it has AOVs.
+ * Needs an OpenGL 4.3 context, see Global::Backend.
+ */
+class WavefrontPathTracer
+{
+private:
+    Shader &generateShader;
+    Shader &prepareShader;
+    Shader &extendShader;
+    Shader &shadeShader;
+    Shader &connectShader;
+    Shader &accumulateShader;
+
+    unsigned int pathBufferID;
+    unsigned int hitBufferID;
+    unsigned int queueBufferID[2];
+    unsigned int shadowBufferID;
+    unsigned int radianceBufferID;
+    unsigned int sampleStartBufferID;
+    unsigned int directBufferID;
+    unsigned int counterBufferID;
+
+    RayCounter rays;
+
+    void GenerateBuffers();
+
+    void DispatchQueue(Shader &shader);
+
+public:
+    WavefrontPathTracer(ShaderCache &cache, const ShaderDefines &defines = ShaderDefines());
+    ~WavefrontPathTracer();
+
+    void ForEachShader(const std::function<void(Shader &)> &function);
+
+    void Render(int firstSample, int samples, AccumulationBuffer &accumulation);
+
+    long long PollRayCount() { return rays.Poll(); }
+};
+
+WavefrontPathTracer::WavefrontPathTracer(ShaderCache &cache, const ShaderDefines &defines)
+    : generateShader(cache.GetCompute("WavefrontGenerate.cs", defines)),
+      prepareShader(cache.GetCompute("WavefrontPrepare.cs", defines)),
+      extendShader(cache.GetCompute("WavefrontExtend.cs", defines)),
+      shadeShader(cache.GetCompute("WavefrontShade.cs", defines)),
+      connectShader(cache.GetCompute("WavefrontConnect.cs", defines)),
+      accumulateShader(cache.GetCompute("WavefrontAccumulate.cs", defines))
+{
+    GenerateBuffers();
+}
+
+WavefrontPathTracer::~WavefrontPathTracer()
+{
+    glDeleteBuffers(1, &pathBufferID);
+    glDeleteBuffers(1, &hitBufferID);
+    glDeleteBuffers(2, queueBufferID);
+    glDeleteBuffers(1, &shadowBufferID);
+    glDeleteBuffers(1, &radianceBufferID);
+    glDeleteBuffers(1, &sampleStartBufferID);
+    glDeleteBuffers(1, &directBufferID);
+    glDeleteBuffers(1, &counterBufferID);
+}
+
+// Sizes follow the std430 structs in Wavefront.glsl, one entry per pixel.
+void WavefrontPathTracer::GenerateBuffers()
+{
+    auto generate = [](unsigned int &bufferID, GLsizeiptr size)
+    {
+        glGenBuffers(1, &bufferID);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, GL_DYNAMIC_COPY);
+    };
+
+    generate(pathBufferID, Global::PixelCount * 16 * sizeof(float));     // PathState
+    generate(hitBufferID, Global::PixelCount * 24 * sizeof(float));      // HitRecord
+    generate(queueBufferID[0], Global::PixelCount * sizeof(unsigned int));
+    generate(queueBufferID[1], Global::PixelCount * sizeof(unsigned int));
+    generate(shadowBufferID, Global::PixelCount * 16 * sizeof(float));   // ShadowRay
+    generate(radianceBufferID, Global::PixelCount * 4 * sizeof(float));
+    generate(sampleStartBufferID, Global::PixelCount * 4 * sizeof(float));
+    generate(directBufferID, Global::PixelCount * 4 * sizeof(float));
+    generate(counterBufferID, 7 * sizeof(unsigned int));
+
+    const unsigned int zeros[7] = {0, 0, 0, 0, 0, 0, 0};
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    rays.Generate();
+}
+
+// Stages after Prepare run one thread per queued path, the work group count is read from CounterBuffer.
+void WavefrontPathTracer::DispatchQueue(Shader &shader)
+{
+    shader.use();
+    glDispatchComputeIndirect(0);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void WavefrontPathTracer::ForEachShader(const std::function<void(Shader &)> &function)
+{
+    function(generateShader);
+    function(prepareShader);
+    function(extendShader);
+    function(shadeShader);
+    function(connectShader);
+    function(accumulateShader);
+}
+
+// Adds samples per pixel to the accumulation, the caller binds the scene textures and swaps the accumulation.
+// firstSample: index of the first of them, see FirstSample in PathTracingCommon.glsl.
+void WavefrontPathTracer::Render(int firstSample, int samples, AccumulationBuffer &accumulation)
+{
+    const unsigned int groupsX = (Global::WindowWidth + 7) / 8;
+    const unsigned int groupsY = (Global::WindowHeight + 7) / 8;
+    const unsigned int zeros[6] = {0, 0, 0, 0, 0, 0};   // every counter but RayCount
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, pathBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, hitBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, shadowBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, radianceBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, counterBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, sampleStartBufferID);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, directBufferID);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counterBufferID);
+    accumulation.BindFeatureImages(2);
+
+    generateShader.use();
+    generateShader.setInt("FirstSample", firstSample);
+    generateShader.setInt("spp", samples);
+    generateShader.setInt("AccumulatedSamples", accumulation.GetSampleCount());
+
+    for (int sample = 0; sample < samples; sample++)
+    {
+        // the previous sample's dispatches wrote the counters atomically, they have to land before the reset.
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBufferID);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros);
+
+        // camera paths land in queue 0, which the first Prepare turns into the input queue.
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, queueBufferID[0]);
+
+        generateShader.use();
+        generateShader.setInt("SampleOffset", sample);
+        glDispatchCompute(groupsX, groupsY, 1);
+
+        int current = 0;
+
+        // MaxDepth bounces plus the hits of the last bounce, which may still land on the light.
+        for (int bounce = 0; bounce <= Global::MaxDepth; bounce++)
+        {
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            prepareShader.use();
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, queueBufferID[current]);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, queueBufferID[1 - current]);
+
+            DispatchQueue(extendShader);
+            DispatchQueue(shadeShader);
+            DispatchQueue(connectShader); // at most one light sample per path, so the shade dispatch size covers it
+
+            current = 1 - current;
+        }
+    }
+
+    accumulateShader.use();
+    accumulateShader.setInt("spp", samples);
+    accumulateShader.setInt("AccumulatedSamples", accumulation.GetSampleCount());
+    accumulation.BindImage(0);
+    accumulation.BindMomentImage(1);
+    accumulation.BindDirectImage(4);
+    glDispatchCompute(groupsX, groupsY, 1);
+
+    // the display pass and the Denoiser sample the result and the features, FrameSaver reads it back through the
+    // framebuffer, ReadBack() and ReadBackFeatures() with glGetTexImage.
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // RayCount of every bounce of this Render(), read by PollRayCount() once the GPU is done.
+    rays.Snapshot(counterBufferID, 6 * sizeof(unsigned int));
+}
+
+#endif
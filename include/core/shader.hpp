@@ -4,12 +4,21 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <map>
 #include <string>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 const std::string path = "./shader/";
+const std::string binaryPath = path + "binary/"; // linked programs of earlier runs, see LoadBinary()
+const bool useProgramBinary = true;
+
+// #define NAME VALUE lines injected after #version, ordered by name so equal sets give equal sources.
+typedef std::map<std::string, std::string> ShaderDefines;
 
 class Shader
 {
@@ -17,7 +26,7 @@ public:
     unsigned int ID;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
-    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr)
+    Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr, const ShaderDefines &defines = ShaderDefines())
     {
         std::string vPath = path + vertexPath;
         std::string fPath = path + fragmentPath;
@@ -45,8 +54,8 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            vertexCode = InjectDefines(ExpandIncludes(vShaderStream.str()), defines);
+            fragmentCode = InjectDefines(ExpandIncludes(fShaderStream.str()), defines);
             // if geometry shader path is present, also load a geometry shader
             if (geometryPath != nullptr)
             {
@@ -55,16 +64,21 @@ public:
                 std::stringstream gShaderStream;
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                geometryCode = InjectDefines(ExpandIncludes(gShaderStream.str()), defines);
             }
         }
         catch (std::ifstream::failure &e)
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        // 2. reuse the program linked by an earlier run if sources and driver are unchanged
+        ID = glCreateProgram();
+        std::string binaryKey = BinaryKey(vertexCode + '\0' + fragmentCode + '\0' + geometryCode);
+        if (LoadBinary(binaryKey))
+            return;
         const char *vShaderCode = vertexCode.c_str();
         const char *fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -87,19 +101,43 @@ public:
             checkCompileErrors(geometry, "GEOMETRY");
         }
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         if (geometryPath != nullptr)
             glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        LinkProgram(binaryKey);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
         if (geometryPath != nullptr)
             glDeleteShader(geometry);
     }
+    // compute shader constructor, needs an OpenGL 4.3 context
+    // ------------------------------------------------------------------------
+    Shader(const char *computePath, const ShaderDefines &defines = ShaderDefines())
+    {
+        std::string computeCode;
+        try
+        {
+            computeCode = InjectDefines(ExpandIncludes(ReadFile(path + computePath)), defines);
+        }
+        catch (std::ifstream::failure &e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        }
+        ID = glCreateProgram();
+        std::string binaryKey = BinaryKey(computeCode);
+        if (LoadBinary(binaryKey))
+            return;
+        const char *cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+        glAttachShader(ID, compute);
+        LinkProgram(binaryKey);
+        glDeleteShader(compute);
+    }
     // activate the shader
     // ------------------------------------------------------------------------
     void use()
@@ -127,6 +165,10 @@ public:
     {
         glUniform1fv(glGetUniformLocation(ID, name.c_str()), size, value);
     }
+    void setIntArray(const std::string &name, int size, const int* value) const
+    {
+        glUniform1iv(glGetUniformLocation(ID, name.c_str()), size, value);
+    }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     {
@@ -136,6 +178,10 @@ public:
     {
         glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
     }
+    void setIVec2(const std::string &name, int x, int y) const
+    {
+        glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y);
+    }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     {
@@ -169,8 +215,160 @@ public:
     {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
+    // ------------------------------------------------------------------------
+    void setBlockBinding(const std::string &name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
 
 private:
+    // read a whole file, throws std::ifstream::failure
+    // ------------------------------------------------------------------------
+    static std::string ReadFile(const std::string &filePath)
+    {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        file.open(filePath);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        return stream.str();
+    }
+    // replace every line #include "file" with the (expanded) file under ./shader/,
+    // GLSL has no include of its own and the path tracing stages share most of their code.
+    // ------------------------------------------------------------------------
+    static std::string ExpandIncludes(const std::string &code)
+    {
+        std::stringstream input(code);
+        std::string result, line;
+        while (std::getline(input, line))
+        {
+            std::size_t begin = line.find("#include \"");
+            if (begin != std::string::npos && line.find_first_not_of(" \t") == begin)
+            {
+                begin += 10;
+                std::size_t end = line.find('"', begin);
+                result += ExpandIncludes(ReadFile(path + line.substr(begin, end - begin))) + "\n";
+            }
+            else
+                result += line + "\n";
+        }
+        return result;
+    }
+    // defines go right after the #version line, which has to stay the first statement.
+    // ------------------------------------------------------------------------
+    static std::string InjectDefines(const std::string &code, const ShaderDefines &defines)
+    {
+        if (defines.empty())
+            return code;
+
+        std::string lines;
+        for (auto &define : defines)
+            lines += "#define " + define.first + " " + define.second + "\n";
+
+        std::size_t version = code.find("#version");
+        std::size_t position = version == std::string::npos ? 0 : code.find('\n', version) + 1;
+        return code.substr(0, position) + lines + code.substr(position);
+    }
+    // program binaries need OpenGL 4.1 and at least one binary format from the driver
+    // ------------------------------------------------------------------------
+    static bool ProgramBinarySupported()
+    {
+        if (!useProgramBinary || !GLAD_GL_VERSION_4_1)
+            return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+    // vendor, renderer and version, a binary is only valid for the driver that produced it
+    // ------------------------------------------------------------------------
+    static std::string DriverString()
+    {
+        std::string driver;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const GLubyte *value = glGetString(name);
+            driver += std::string(value != nullptr ? (const char *)value : "") + "|";
+        }
+        return driver;
+    }
+    // FNV-1a hash of the expanded sources (defines included) as file name of the binary
+    // ------------------------------------------------------------------------
+    static std::string BinaryKey(const std::string &sources)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : sources)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        std::stringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return stream.str();
+    }
+    // binary file: driver string line, format, length, program binary.
+    // any mismatch or a failed link leaves ID untouched and the caller compiles from source.
+    // ------------------------------------------------------------------------
+    bool LoadBinary(const std::string &key)
+    {
+        if (!ProgramBinarySupported())
+            return false;
+        std::ifstream file(binaryPath + key + ".bin", std::ios::binary);
+        if (!file.is_open())
+            return false;
+        std::string driver;
+        std::getline(file, driver);
+        if (driver != DriverString())
+            return false;
+        GLenum format = 0;
+        GLint length = 0;
+        file.read((char *)&format, sizeof(format));
+        file.read((char *)&length, sizeof(length));
+        if (!file || length <= 0)
+            return false;
+        std::vector<char> binary(length);
+        file.read(binary.data(), length);
+        if (!file)
+            return false;
+        glProgramBinary(ID, format, binary.data(), length);
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success != 0;
+    }
+    // ------------------------------------------------------------------------
+    void StoreBinary(const std::string &key)
+    {
+        GLint length = 0;
+        glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(ID, length, NULL, &format, binary.data());
+        std::ofstream file(binaryPath + key + ".bin", std::ios::binary);
+        if (!file.is_open())
+            return;
+        file << DriverString() << '\n';
+        file.write((const char *)&format, sizeof(format));
+        file.write((const char *)&length, sizeof(length));
+        file.write(binary.data(), length);
+    }
+    // link the attached shaders and keep the result for the next run
+    // ------------------------------------------------------------------------
+    void LinkProgram(const std::string &key)
+    {
+        bool binary = ProgramBinarySupported();
+        if (binary)
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        if (binary && success)
+            StoreBinary(key);
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,81 @@
+#version 330 core
+
+// Denoiser pass 1 ~ N: one iteration of the edge-avoiding A-trous wavelet filter (Dammertz et al. 2010),
+// with the luminance weight scaled by the estimated noise (Schied et al. 2017, SVGF).
+// Keep in sync with Denoiser::RunCpu().
+
+// Variables-------------------------------------------------------------------
+#define MIN_ALBEDO 0.01                        // Keep in sync with DenoisePrepare.fs
+
+layout (location = 0) out vec4 Filtered;      // rgb: illumination, a: its variance; radiance and 1 after the last iteration
+
+uniform sampler2D Illumination;                // Output of the previous pass
+uniform sampler2D Albedo;                      // AccumulationBuffer::UseFeatureTextures()
+uniform sampler2D Normal;                      // xyz: Normal, w: Distance to the first hit
+uniform ivec2     RenderSize;                  // Rendered part of the textures
+uniform int       StepSize;                    // Pixels between the taps, 2^iteration
+uniform bool      Modulate;                    // Last iteration: multiply the albedo back in
+
+uniform float     SigmaLuminance;              // Global::DenoiseSigma*
+uniform float     SigmaNormal;
+uniform float     SigmaDepth;
+uniform float     SigmaAlbedo;
+
+const float Kernel[3] = float[3](3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f);   // B3 spline, taps 0, 1, 2
+
+// Declaration-----------------------------------------------------------------
+void  main();
+float Luminance(vec3 color);
+
+// Main------------------------------------------------------------------------
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    vec4 center = texelFetch(Illumination, texel, 0);
+    vec4 centerNormal = texelFetch(Normal, texel, 0);
+    vec3 centerAlbedo = texelFetch(Albedo, texel, 0).rgb;
+
+    float centerLuminance = Luminance(center.rgb);
+    float luminanceScale = SigmaLuminance * sqrt(center.a) + 1.0e-6f;
+
+    float weightSum = Kernel[0] * Kernel[0];
+    vec3 sum = weightSum * center.rgb;
+    float variance = weightSum * weightSum * center.a;
+
+    for (int y = -2; y <= 2; y++)
+        for (int x = -2; x <= 2; x++)
+        {
+            ivec2 neighbour = texel + ivec2(x, y) * StepSize;
+            if ((x == 0 && y == 0) || any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, RenderSize)))
+                continue;
+
+            vec4 value = texelFetch(Illumination, neighbour, 0);
+            vec4 normal = texelFetch(Normal, neighbour, 0);
+            vec3 albedo = texelFetch(Albedo, neighbour, 0).rgb;
+
+            // edge-stopping functions: noise-relative luminance, normal, hit distance per pixel of distance, albedo.
+            float pixels = float(StepSize) * length(vec2(x, y));
+            float luminanceWeight = abs(centerLuminance - Luminance(value.rgb)) / luminanceScale;
+            float depthWeight = abs(centerNormal.w - normal.w) / (SigmaDepth * centerNormal.w * pixels + 1.0e-6f);
+            float albedoWeight = length(centerAlbedo - albedo) / SigmaAlbedo;
+            float normalWeight = pow(max(dot(centerNormal.xyz, normal.xyz), 0.0f), SigmaNormal);
+
+            float weight = Kernel[abs(x)] * Kernel[abs(y)] * normalWeight * exp(-luminanceWeight - depthWeight - albedoWeight);
+
+            sum += weight * value.rgb;
+            variance += weight * weight * value.a;
+            weightSum += weight;
+        }
+
+    Filtered = vec4(sum / weightSum, variance / (weightSum * weightSum));
+
+    // an accumulation of one sample, shown and saved like any other.
+    if (Modulate)
+        Filtered = vec4(Filtered.rgb * max(centerAlbedo, vec3(MIN_ALBEDO)), 1.0f);
+}
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
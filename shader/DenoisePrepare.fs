@@ -0,0 +1,79 @@
+#version 330 core
+
+// Denoiser pass 0: demodulated illumination of every pixel and the variance of its estimate,
+// the input of the first DenoiseAtrous.fs iteration. Keep in sync with Denoiser::RunCpu().
+
+// Variables-------------------------------------------------------------------
+#define MIN_ALBEDO 0.01                        // Albedo is clamped to this before demodulation
+
+layout (location = 0) out vec4 Illumination;  // rgb: radiance / albedo, a: variance of its luminance
+
+uniform sampler2D Accumulation;                // rgb: sum of radiance, a: number of samples
+uniform sampler2D Moments;                     // Sum of the squared luminance of all samples
+uniform sampler2D Albedo;                      // AccumulationBuffer::UseFeatureTextures()
+uniform ivec2     RenderSize;                  // Rendered part of the textures
+uniform int       TemporalSamples;             // Samples a pixel needs before its own moments estimate the variance
+
+// Declaration-----------------------------------------------------------------
+void  main();
+float Luminance(vec3 color);
+vec3  Demodulate(ivec2 texel);
+
+// Main------------------------------------------------------------------------
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    vec4 accumulation = texelFetch(Accumulation, texel, 0);
+    float n = max(accumulation.a, 1.0f);
+    float moment = texelFetch(Moments, texel, 0).r;
+
+    vec3 illumination = Demodulate(texel);
+    float albedo = Luminance(max(texelFetch(Albedo, texel, 0).rgb, vec3(MIN_ALBEDO)));
+
+    float variance;
+    if (n >= float(TemporalSamples) && moment > 0.0f)
+    {
+        // standard error of the pixel's mean from its own samples, scaled like the demodulated luminance.
+        float mean = Luminance(accumulation.rgb) / n;
+        variance = max(moment / n - mean * mean, 0.0f) / (n * albedo * albedo);
+    }
+    else
+    {
+        // too few samples (or no moments, e.g. an assembled coordinator image): spread of the 3x3 neighbourhood.
+        float sum = 0.0f;
+        float squares = 0.0f;
+        float count = 0.0f;
+
+        for (int y = -1; y <= 1; y++)
+            for (int x = -1; x <= 1; x++)
+            {
+                ivec2 neighbour = texel + ivec2(x, y);
+                if (any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, RenderSize)))
+                    continue;
+
+                float luminance = Luminance(Demodulate(neighbour));
+                sum += luminance;
+                squares += luminance * luminance;
+                count += 1.0f;
+            }
+
+        variance = max(squares / count - (sum / count) * (sum / count), 0.0f);
+    }
+
+    Illumination = vec4(illumination, variance);
+}
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Average radiance divided by the albedo: what's left is lighting, which is smooth across texture detail.
+vec3 Demodulate(ivec2 texel)
+{
+    vec4 accumulation = texelFetch(Accumulation, texel, 0);
+    vec3 albedo = max(texelFetch(Albedo, texel, 0).rgb, vec3(MIN_ALBEDO));
+
+    return accumulation.rgb / max(accumulation.a, 1.0f) / albedo;
+}
@@ -0,0 +1,63 @@
+#version 330 core
+
+// Variables-------------------------------------------------------------------
+#define TONEMAP_CLAMP    0                     // Tone mapping operators, keep in sync with Global::ToneMapType
+#define TONEMAP_REINHARD 1
+#define TONEMAP_ACES     2
+
+in vec2 texCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D Accumulation;                // rgb: sum of radiance, a: number of samples
+uniform int       ToneMapping;                 // TONEMAP_*
+uniform float     Exposure;
+uniform float     Gamma;
+uniform vec2      RenderScale;                 // Rendered part of Accumulation, < 1 while the resolution is reduced
+uniform bool      ShowSampleCount;             // Samples of every pixel relative to SampleCount instead of the image
+uniform float     SampleCount;                 // Samples of the pixels that never converged
+
+// Declaration-----------------------------------------------------------------
+void main();
+vec3 ToneMap(vec3 color);
+
+// Main------------------------------------------------------------------------
+void main()
+{
+    // bilinear upsampling of the rendered part, clamped so texels outside of it never bleed in.
+    vec2 halfTexel = 0.5f / vec2(textureSize(Accumulation, 0));
+    vec2 uv = clamp(texCoords * RenderScale, halfTexel, RenderScale - halfTexel);
+
+    vec4 accumulation = texture(Accumulation, uv);
+
+    if (ShowSampleCount)
+    {
+        FragColor = vec4(vec3(accumulation.a / max(SampleCount, 1.0f)), 1.0f);
+        return;
+    }
+
+    vec3 color = accumulation.rgb / max(accumulation.a, 1.0f);
+
+    FragColor = vec4(ToneMap(color), 1.0f);
+}
+
+// Tone mapping----------------------------------------------------------------
+// Keep in sync with FrameSaver::ToneMap().
+vec3 ToneMap(vec3 color)
+{
+    color *= Exposure;
+
+    switch (ToneMapping)
+    {
+    case TONEMAP_REINHARD:
+        color = color / (1.0f + color);
+        break;
+    case TONEMAP_ACES:
+        color = (color * (2.51f * color + 0.03f)) / (color * (2.43f * color + 0.59f) + 0.14f);
+        break;
+    default:
+        break;
+    }
+
+    return pow(clamp(color, 0.0f, 1.0f), vec3(1.0f / Gamma));
+}
\ No newline at end of file
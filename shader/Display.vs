@@ -0,0 +1,12 @@
+#version 330 core
+
+out vec2 texCoords;
+
+// Fullscreen triangle, no vertex buffer needed: (-1, -1), (3, -1), (-1, 3).
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+    texCoords = position;
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
\ No newline at end of file
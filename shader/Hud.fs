@@ -0,0 +1,29 @@
+#version 330 core
+
+// Variables-------------------------------------------------------------------
+#define HUD_COLUMNS 20                         // Keep in sync with Hud::Columns and Hud::Rows
+#define HUD_ROWS    6
+
+out vec4 FragColor;
+
+uniform int   Glyphs[HUD_COLUMNS * HUD_ROWS];  // 3x5 bitmaps, bit 14 is the top left pixel, row by row
+uniform ivec2 Origin;                          // lower left corner of the HUD in window pixels
+uniform int   HudScale;                        // window pixels per font pixel
+
+// Main------------------------------------------------------------------------
+// Every character is a 4x6 cell: the glyph in the top left 3x5, one pixel of spacing right and below.
+void main()
+{
+    ivec2 p = (ivec2(gl_FragCoord.xy) - Origin) / HudScale;
+
+    int column = p.x / 4;
+    int row = HUD_ROWS - 1 - p.y / 6;
+    int x = p.x % 4;
+    int y = 5 - p.y % 6;                       // from the top of the cell
+
+    bool lit = false;
+    if (x < 3 && y < 5)
+        lit = ((Glyphs[row * HUD_COLUMNS + column] >> (14 - (y * 3 + x))) & 1) != 0;
+
+    FragColor = lit ? vec4(1.0f, 1.0f, 1.0f, 1.0f) : vec4(0.0f, 0.0f, 0.0f, 0.6f);
+}
@@ -0,0 +1,822 @@
+// Shared by SimplePathTracing.fs and the Wavefront*.cs compute stages, no #version here.
+// Included through Shader::ReadShaderFile(), which expands #include "file" relative to ./shader/.
+
+// Variables-------------------------------------------------------------------
+#define EPSILON 0.0001                         // Float EPSILON
+#define PI      3.1415926535897                // PI
+
+#define SAMPLER_INDEPENDENT 0                  // Samplers, keep in sync with Global::SamplerType
+#define SAMPLER_STRATIFIED  1
+#define SAMPLER_HALTON      2
+#define SAMPLER_SOBOL       3
+#define SAMPLER_BLUE_NOISE  4
+#define HALTON_DIMENSIONS   32                 // Number of primes in HaltonPrimes
+
+#define BSDF_LAMBERTIAN     0                  // BSDF models, see EvalBSDF / PDFBSDF / SampleBSDF
+
+#define NO_HIT_DEPTH 1.0e30                    // Primary hit distance of a camera ray that left the scene
+
+#define LEFT_HAND_COORDS
+
+layout (std140) uniform CameraBlock            // Camera::UpdateUniformBlock()
+{
+    mat4 RayRotateMatrix;                      // Rotation of camera
+    vec4 Eye;                                  // xyz: Position of eye
+    vec4 Screen;                               // Width, Height, tan(FOV / 2), Aspect Ratio
+};
+
+uniform sampler2D TriData;                     // Scene Data aka Triangle Data
+uniform sampler2D MatData;                     // Material Data
+uniform sampler2D BlueNoise;                   // Tiled blue-noise ranks
+// uniform sampler2D TexData;                  // TODO: Texture Mapping will be supported in later version(Maybe)
+
+uniform int        spp;                        // Samples Per Pixel of this pass
+uniform int        FirstSample;                // Index of the pass' first sample, sample i of the pass is FirstSample + i
+uniform int        SampleCount;                // Samples per pixel of a whole image, used for stratification
+uniform int        BlueNoiseDimensions;        // Number of dimensions covered by blue-noise
+uniform float[12]  DefaultMat;                 // Default Material
+uniform float      IndirLightContriRate;       // Indirect Light Contribution Rate
+
+uniform bool       AdaptiveSampling;           // Converged pixels stop receiving samples, see IsConverged()
+uniform float      AdaptiveThreshold;          // Relative standard error of a converged pixel
+uniform int        AdaptiveMinSamples;         // Samples before the variance estimate is trusted
+
+// Permutations: Utility::PathTracingDefines() injects these after #version, a missing define keeps the uniform.
+#ifdef SAMPLER_TYPE
+const int          SamplerType = SAMPLER_TYPE;
+#else
+uniform int        SamplerType;                // Sampler used by Rand(), see SAMPLER_*
+#endif
+
+#ifdef MAX_DEPTH
+const int          MaxDepth = MAX_DEPTH;
+#else
+uniform int        MaxDepth;                   // Maximum number of bounces
+#endif
+
+#ifdef RUSSIAN_ROULETTE_DEPTH
+const int          RussianRouletteDepth = RUSSIAN_ROULETTE_DEPTH;
+#else
+uniform int        RussianRouletteDepth;       // Bounces before Russian Roulette starts
+#endif
+
+uint  rdPixel;                                 // Random key: pixel index
+uint  rdSample;                                // Random key: sample index
+uint  rdDimension;                             // Random key: dimension, increased by every Rand()
+float pdfLight;                                // PDF of light, area measure over all emitters
+float lightArea;                               // Total area of all emitters
+vec3  debugger   = vec3(1.0, 1.0, 1.0);        // Only for debug(it's too hard to debug in GLSL)
+vec3  lightColor = vec3(1.0, 1.0, 1.0);        // Default light color
+
+ivec2 triTexSizeVec;
+ivec2 matTexSizeVec;
+int triTexSize;
+int matTexSize;
+
+vec3 emit = 2 * (8.0f  * vec3(0.747f + 0.058f, 0.747f + 0.258f, 0.747f) +
+                15.6f * vec3(0.740f + 0.287f, 0.740f + 0.160f, 0.740f) +
+                18.4f * vec3(0.737f + 0.642f, 0.737f + 0.159f, 0.737f));
+
+// Struct----------------------------------------------------------------------
+struct Ray
+{
+    vec3 origin;
+    vec3 direction;
+};
+
+struct Triangle
+{
+    vec3 v0;
+    vec3 v1;
+    vec3 v2;
+    vec3 t0;
+    vec3 t1;
+    vec3 t2;
+    vec3 n0;
+    vec3 n1;
+    vec3 n2;
+};
+
+struct Intersection
+{
+    bool happened; // isIntersect
+    bool isLight;
+    vec3 coords;
+    vec3 normal;
+    vec3 Ka;
+    vec3 Kd;
+    vec3 Ks;
+    vec3 Ke;
+    float distance;
+    int bsdf;      // BSDF_*
+    float material; // Key of the material (hash of its name, see ModelData), the material ID AOV
+};
+
+struct Material
+{
+    float key;
+    vec3 Ka;
+    vec3 Kd;
+    vec3 Ks;
+    vec3 Ke;
+};
+
+// Declaration-----------------------------------------------------------------
+
+// Scene
+void InitScene   ();
+void InitLights  ();
+vec3 GenerateRay (vec2 fragCoord);
+
+// Shading
+float Luminance (vec3 color);
+
+// Adaptive sampling
+bool  IsConverged (vec4 accumulated, float moment);
+
+// Denoiser features
+void  FirstHitFeatures (Ray ray, Intersection primary, out vec4 albedo, out vec4 normal);
+
+// Multiple importance sampling
+float PowerHeuristic (float pdfA, float pdfB);
+
+// Texture
+vec3 Texture(sampler2D tex, vec2 coords, ivec2 sizeVec);
+vec3 Texture(sampler2D tex, int index, ivec2 sizeVec);
+
+// Material
+Material GetDefaultMat();
+
+// Random
+uint  Pcg          (uint v);
+uint  ReverseBits  (uint v);
+uint  Permute      (uint i, uint l, uint p);
+float UintToFloat  (uint v);
+void  InitRand     (uint sampleIndex);
+float Rand         ();
+
+// Sampler, every sampler is indexed by (pixel, sample, dimension)
+float SampleIndependent(uint pixel, uint sampleIndex, uint dimension);
+float SampleStratified (uint pixel, uint sampleIndex, uint dimension);
+float SampleHalton     (uint pixel, uint sampleIndex, uint dimension);
+float SampleSobol      (uint pixel, uint sampleIndex, uint dimension);
+float SampleBlueNoise  (uint pixel, uint sampleIndex, uint dimension);
+float GetRandFloat ();
+
+// BSDF interface, wo points to the viewer and wi to the light, both away from the surface
+vec3  EvalBSDF   (Intersection inter, vec3 wo, vec3 wi, vec3 N);
+float PDFBSDF    (Intersection inter, vec3 wo, vec3 wi, vec3 N);
+vec3  SampleBSDF (Intersection inter, vec3 wo, vec3 N);
+
+// BSDF models
+vec3  LocalToWorld           (vec3 local, vec3 N);
+vec3  LambertianBRDF         (vec3 wi, vec3 N, vec3 Kd);
+float PDFCosineHemisphere    (vec3 wi, vec3 N);
+vec3  SampleCosineHemisphere (vec3 N);
+
+// Intersection
+Intersection IntersectTriangle (Ray ray, Triangle triangle);
+Intersection IntersectScene    (Ray ray);
+
+// Triangle Process
+float        GetTriangleArea     (Triangle triangle);
+float        GetLightArea        ();
+Intersection SampleTriangleLight (Triangle triangle);
+Intersection SampleLight         ();
+
+// Scene-----------------------------------------------------------------------
+// Called once per invocation before any intersection.
+void InitScene()
+{
+    triTexSizeVec = textureSize(TriData, 0);
+    matTexSizeVec = textureSize(MatData, 0);
+    triTexSize = triTexSizeVec.x * triTexSizeVec.y;
+    matTexSize = matTexSizeVec.x * matTexSizeVec.y;
+}
+
+// Called after InitScene() before any light sampling, walks the whole scene once.
+void InitLights()
+{
+#ifdef LIGHT_AREA
+    lightArea = LIGHT_AREA;                    // ModelData::GetLightArea(), saves a walk over the scene
+#else
+    lightArea = GetLightArea();
+#endif
+    pdfLight = lightArea > 0.0f ? 1.0f / lightArea : 0.0f;
+}
+
+// Camera space direction through fragCoord (window coordinates, pixel centers at +0.5).
+vec3 GenerateRay(vec2 fragCoord)
+{
+    vec2 screenCoords = 2.0f * fragCoord / Screen.xy - 1.0f; // OpenGL 屏幕坐标原点在左下角
+
+#ifdef LEFT_HAND_COORDS
+    screenCoords.x = -screenCoords.x; // Left-Hand Coordinate
+#endif
+
+    return normalize(vec3(screenCoords.x * Screen.w * Screen.z, screenCoords.y * Screen.z, 1.0f));
+}
+
+// Shading---------------------------------------------------------------------
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Adaptive sampling-----------------------------------------------------------
+// accumulated: radiance sum and sample count of a pixel, moment: sum of the squared luminance of its samples.
+// Converged once the standard error of the mean luminance falls below AdaptiveThreshold times the mean.
+bool IsConverged(vec4 accumulated, float moment)
+{
+    float n = accumulated.a;
+    if (!AdaptiveSampling || n < float(max(AdaptiveMinSamples, 2)))
+        return false;
+
+    float mean = Luminance(accumulated.rgb) / n;
+    float variance = max(moment / n - mean * mean, 0.0f) * n / (n - 1.0f);
+
+    return sqrt(variance / n) <= AdaptiveThreshold * max(mean, 1.0e-3f);
+}
+
+// Denoiser features----------------------------------------------------------
+// Guides of the Denoiser's edge-stopping functions and AOVs. Camera rays go through the pixel center, so a pixel's
+// first hit and its features are the same for every sample and are simply overwritten by every pass.
+// albedo: rgb diffuse reflectance, 1 on lights and outside the scene, where nothing is demodulated.
+//         a material key of the hit, -1 outside the scene.
+// normal: xyz facing the camera (the reversed ray outside the scene), w distance to the hit or NO_HIT_DEPTH.
+void FirstHitFeatures(Ray ray, Intersection primary, out vec4 albedo, out vec4 normal)
+{
+    if (!primary.happened)
+    {
+        albedo = vec4(1.0f, 1.0f, 1.0f, -1.0f);
+        normal = vec4(-ray.direction, NO_HIT_DEPTH);
+        return;
+    }
+
+    vec3 N = normalize(primary.normal);
+    if (dot(N, ray.direction) > 0.0f)
+        N = -N;
+
+    albedo = vec4(primary.isLight ? vec3(1.0f) : primary.Kd, primary.material);
+    normal = vec4(N, primary.distance);
+}
+
+// Multiple importance sampling------------------------------------------------
+float PowerHeuristic(float pdfA, float pdfB)
+{
+    float a = pdfA * pdfA;
+    float b = pdfB * pdfB;
+
+    return a + b > 0.0f ? a / (a + b) : 0.0f;
+}
+
+// Texture---------------------------------------------------------------------
+vec3 Texture(sampler2D tex, vec2 coords, ivec2 sizeVec2)
+{
+    vec2 vec = vec2(coords.x / (sizeVec2.x - 1), coords.y / (sizeVec2.y - 1));
+    return texture(tex, vec).xyz;
+}
+
+vec3 Texture(sampler2D tex, int index, ivec2 sizeVec2)
+{
+    vec2 coords = ivec2(index % sizeVec2.x, index / sizeVec2.y);
+    vec2 vec = vec2(coords.x / (sizeVec2.x - 1), coords.y / (sizeVec2.y - 1));
+    return texture(tex, vec).xyz;
+}
+
+// Material--------------------------------------------------------------------
+Material GetDefaultMat()
+{
+    Material mat;
+    mat.key = 0;
+    mat.Ka = vec3(DefaultMat[0], DefaultMat[1], DefaultMat[2]);
+    mat.Kd = vec3(DefaultMat[3], DefaultMat[4], DefaultMat[5]);
+    mat.Ks = vec3(DefaultMat[6], DefaultMat[7], DefaultMat[8]);
+    mat.Ke = vec3(DefaultMat[9], DefaultMat[10], DefaultMat[11]);
+
+    return mat;
+}
+
+// Random----------------------------------------------------------------------
+// PCG hash (Jarkko & Olano, "Hash Functions for GPU Rendering", 2020).
+uint Pcg(uint v)
+{
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// GLSL 3.30 has no bitfieldReverse().
+uint ReverseBits(uint v)
+{
+    v = ((v >> 1u) & 0x55555555u) | ((v & 0x55555555u) << 1u);
+    v = ((v >> 2u) & 0x33333333u) | ((v & 0x33333333u) << 2u);
+    v = ((v >> 4u) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4u);
+    v = ((v >> 8u) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8u);
+    return (v >> 16u) | (v << 16u);
+}
+
+// Random permutation of i in [0, l) selected by p (Kensler, "Correlated Multi-Jittered Sampling", 2013).
+uint Permute(uint i, uint l, uint p)
+{
+    uint w = l - 1u;
+    w |= w >> 1u;
+    w |= w >> 2u;
+    w |= w >> 4u;
+    w |= w >> 8u;
+    w |= w >> 16u;
+
+    do
+    {
+        i ^= p;             i *= 0xe170893du;
+        i ^= p >> 16u;      i ^= (i & w) >> 4u;
+        i ^= p >> 8u;       i *= 0x0929eb3fu;
+        i ^= p >> 23u;      i ^= (i & w) >> 1u;
+        i *= 1u | p >> 27u; i *= 0x6935fa69u;
+        i ^= (i & w) >> 11u; i *= 0x74dcb303u;
+        i ^= (i & w) >> 2u; i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2u; i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5u;
+    } while (i >= l);
+
+    return (i + p) % l;
+}
+
+// [0.0f, 1.0f), upper 24 bits are exactly representable.
+float UintToFloat(uint v)
+{
+    return float(v >> 8u) * (1.0f / 16777216.0f);
+}
+
+// Called once per sample: every sample restarts at dimension 0.
+void InitRand(uint sampleIndex)
+{
+    rdSample = sampleIndex;
+    rdDimension = 0u;
+}
+
+// [0.0f, 1.0f), keyed by (pixel, sample, dimension)
+float Rand()
+{
+    float result;
+
+    switch (SamplerType)
+    {
+    case SAMPLER_STRATIFIED:
+        result = SampleStratified(rdPixel, rdSample, rdDimension);
+        break;
+    case SAMPLER_HALTON:
+        result = SampleHalton(rdPixel, rdSample, rdDimension);
+        break;
+    case SAMPLER_SOBOL:
+        result = SampleSobol(rdPixel, rdSample, rdDimension);
+        break;
+    case SAMPLER_BLUE_NOISE:
+        result = SampleBlueNoise(rdPixel, rdSample, rdDimension);
+        break;
+    default:
+        result = SampleIndependent(rdPixel, rdSample, rdDimension);
+        break;
+    }
+
+    rdDimension++;
+    return result;
+}
+
+// 0 ~ 1
+float GetRandFloat()
+{
+    return Rand();
+}
+
+// Sampler---------------------------------------------------------------------
+const uint HaltonPrimes[HALTON_DIMENSIONS] = uint[](
+    2u,   3u,   5u,   7u,   11u,  13u,  17u,  19u,  23u,  29u,  31u,  37u,  41u,  43u,  47u,  53u,
+    59u,  61u,  67u,  71u,  73u,  79u,  83u,  89u,  97u,  101u, 103u, 107u, 109u, 113u, 127u, 131u);
+
+// Sobol direction numbers of the first 4 dimensions (Joe & Kuo, new-joe-kuo-6.21201).
+const uint SobolDirections[128] = uint[](
+    0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+    0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+    0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+    0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+
+    0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+    0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+    0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+    0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+
+    0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+    0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+    0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+    0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+
+    0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+    0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+    0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+    0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u);
+
+float SampleIndependent(uint pixel, uint sampleIndex, uint dimension)
+{
+    return UintToFloat(Pcg(pixel ^ Pcg(sampleIndex ^ Pcg(dimension))));
+}
+
+// Every dimension is stratified into SampleCount strata, visited in a per (pixel, dimension) random order.
+float SampleStratified(uint pixel, uint sampleIndex, uint dimension)
+{
+    uint count = uint(max(SampleCount, 1));
+    uint seed = Pcg(pixel ^ Pcg(dimension ^ Pcg(sampleIndex / count)));
+    uint stratum = Permute(sampleIndex % count, count, seed);
+    float jitter = UintToFloat(Pcg(seed ^ sampleIndex));
+
+    return (float(stratum) + jitter) / float(count);
+}
+
+// Radical inverse of the sample index, Cranley-Patterson rotated per (pixel, dimension).
+float SampleHalton(uint pixel, uint sampleIndex, uint dimension)
+{
+    if (dimension >= uint(HALTON_DIMENSIONS))
+        return SampleIndependent(pixel, sampleIndex, dimension);
+
+    uint base = HaltonPrimes[dimension];
+    float invBase = 1.0f / float(base);
+    float factor = invBase;
+    float result = 0.0f;
+
+    for (uint i = sampleIndex + 1u; i > 0u; i /= base)
+    {
+        result += float(i % base) * factor;
+        factor *= invBase;
+    }
+
+    return fract(result + UintToFloat(Pcg(pixel ^ Pcg(dimension))));
+}
+
+// Owen-scrambled Sobol, padded in 4D blocks (Burley, "Practical Hash-based Owen Scrambling", 2020).
+float SampleSobol(uint pixel, uint sampleIndex, uint dimension)
+{
+    uint seed = Pcg(pixel ^ Pcg(dimension / 4u));
+
+    // nested uniform scramble of the index shuffles the sequence per pixel and block.
+    uint index = ReverseBits(sampleIndex);
+    index += seed;
+    index ^= index * 0x6c50b47cu;
+    index ^= index * 0xb82f1e52u;
+    index ^= index * 0xc7afe638u;
+    index ^= index * 0x8d22f6e6u;
+    index = ReverseBits(index);
+
+    uint offset = (dimension % 4u) * 32u;
+    uint x = 0u;
+    for (uint bit = 0u; bit < 32u && index != 0u; bit++, index >>= 1u)
+    {
+        if ((index & 1u) != 0u)
+            x ^= SobolDirections[offset + bit];
+    }
+
+    // Owen scramble of the point itself, the Laine-Karras permutation works on reversed bits.
+    seed = Pcg(seed ^ dimension);
+    x = ReverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    x = ReverseBits(x);
+
+    return UintToFloat(x);
+}
+
+// Blue-noise tile shifted per dimension, rotated over samples by the golden ratio.
+float SampleBlueNoise(uint pixel, uint sampleIndex, uint dimension)
+{
+    if (dimension >= uint(BlueNoiseDimensions))
+        return SampleIndependent(pixel, sampleIndex, dimension);
+
+    uint width = uint(Screen.x);
+    uint shift = Pcg(dimension);
+    ivec2 size = textureSize(BlueNoise, 0);
+    ivec2 coords = (ivec2(pixel % width, pixel / width) + ivec2(shift & 0xFFFFu, shift >> 16u)) % size;
+    float rank = texelFetch(BlueNoise, coords, 0).r;
+
+    return fract(rank + float(sampleIndex) * 0.61803398875f);
+}
+
+// BSDF------------------------------------------------------------------------
+// New models only need a BSDF_* id and a case in the three functions below.
+vec3 EvalBSDF(Intersection inter, vec3 wo, vec3 wi, vec3 N)
+{
+    switch (inter.bsdf)
+    {
+    default:
+        return LambertianBRDF(wi, N, inter.Kd);
+    }
+}
+
+// Solid angle measure.
+float PDFBSDF(Intersection inter, vec3 wo, vec3 wi, vec3 N)
+{
+    switch (inter.bsdf)
+    {
+    default:
+        return PDFCosineHemisphere(wi, N);
+    }
+}
+
+vec3 SampleBSDF(Intersection inter, vec3 wo, vec3 N)
+{
+    switch (inter.bsdf)
+    {
+    default:
+        return SampleCosineHemisphere(N);
+    }
+}
+
+vec3 LocalToWorld(vec3 local, vec3 N)
+{
+    vec3 B, C;
+    if (abs(N.x) > abs(N.y))
+    {
+        float invLen = 1.0f / sqrt(N.x * N.x + N.z * N.z);
+        C = vec3(N.z * invLen, 0.0f, -N.x * invLen);
+    }
+    else
+    {
+        float invLen = 1.0f / sqrt(N.y * N.y + N.z * N.z);
+        C = vec3(0.0f, N.z * invLen, -N.y * invLen);
+    }
+    B = cross(C, N);
+
+    return local.x * B + local.y * C + local.z * N;
+}
+
+vec3 LambertianBRDF(vec3 wi, vec3 N, vec3 Kd)
+{
+    if (dot(N, wi) > 0.0f)
+        return Kd / PI;
+    else
+        return vec3(0.0f);
+}
+
+float PDFCosineHemisphere(vec3 wi, vec3 N)
+{
+    float cosTheta = dot(wi, N);
+
+    return cosTheta > 0.0f ? cosTheta / PI : 0.0f;
+}
+
+// Malley's method: uniform disk sample projected up to the hemisphere.
+vec3 SampleCosineHemisphere(vec3 N)
+{
+    float x1 = GetRandFloat(), x2 = GetRandFloat();
+    float r = sqrt(x1), phi = 2 * PI * x2;
+    vec3 localRay = vec3(r * cos(phi), r * sin(phi), sqrt(max(0.0f, 1.0f - x1)));
+
+    return LocalToWorld(localRay, N);
+}
+
+// Intersection----------------------------------------------------------------
+Intersection IntersectTriangle(Ray ray, Triangle triangle)
+{
+    Intersection inter;
+	inter.happened = false;
+
+	vec3 e1 = triangle.v1 - triangle.v0;
+    vec3 e2 = triangle.v2 - triangle.v0;
+
+    vec3 triangleNormal = normalize(cross(e1, e2));
+    if (dot(ray.direction, triangleNormal) > 0)
+        return inter;
+
+    vec3 pvec = cross(ray.direction, e2);
+    float det = dot(e1, pvec);
+    if (abs(det) < EPSILON)
+        return inter;
+
+    float det_inv = 1.0 / det;
+    vec3 tvec = ray.origin - triangle.v0;
+    float u = dot(tvec, pvec) * det_inv;
+    if (u < 0 || u > 1)
+        return inter;
+
+    vec3 qvec = cross(tvec, e1);
+    float v = dot(ray.direction, qvec) * det_inv;
+    if (v < 0 || u + v > 1)
+        return inter;
+
+    float t_tmp = dot(e2, qvec) * det_inv;
+    if (t_tmp < 0)
+        return inter;
+
+    inter.happened = true;
+    inter.coords = ray.origin + ray.direction * t_tmp;
+    inter.normal = triangleNormal;
+    inter.distance = t_tmp;
+
+    return inter;
+}
+
+Intersection IntersectScene(Ray ray)
+{
+	Intersection inter, temp;
+	inter.happened = false;
+
+	float minDistance = -1;
+
+    Material material = GetDefaultMat();
+    Triangle triangle;
+
+    float curKey, resKey;
+    bool curIsLight = false, resIsLight = false;
+
+    vec3 res;
+    vec3 data[9];
+    int dataCounter = 0;
+
+    for (int counter = 0; counter < triTexSize; counter++)
+    {
+        res = Texture(TriData, counter, triTexSizeVec);
+
+        if (res.x == -10086)
+        {
+            curKey = res.y;
+            curIsLight = res.z == 1.0 ? true : false;
+            continue;
+        }
+        if (res.x == -10087)
+        {
+            continue;
+        }
+        if (res.xyz == vec3(-500, -140, -400))
+            break;
+
+        data[dataCounter++] = res.xyz;
+
+        if (dataCounter == 9)
+        {
+            dataCounter = 0;
+
+            triangle = Triangle(data[0], data[1], data[2],
+                                data[3], data[4], data[5],
+                                data[6], data[7], data[8]);
+
+            temp = IntersectTriangle(ray, triangle);
+            if (temp.happened && (temp.distance <= minDistance || minDistance < 0))
+		    {
+                resKey = curKey;
+                resIsLight = curIsLight;
+		    	inter = temp;
+		    	minDistance = temp.distance;
+		    }
+        }
+    }
+
+    for (int counter = 0; counter < matTexSize; counter++)
+    {
+        res = Texture(MatData, counter, matTexSizeVec);
+
+        if (res.x == -10090 && res.y == resKey)
+        {
+            vec3 Ka = Texture(MatData, counter + 1, matTexSizeVec);
+            vec3 Kd = Texture(MatData, counter + 2, matTexSizeVec);
+            vec3 Ks = Texture(MatData, counter + 3, matTexSizeVec);
+            vec3 Ke = Texture(MatData, counter + 4, matTexSizeVec);
+            material = Material(resKey, Ka, Kd, Ks, Ke);
+            break;
+        }
+        if (res.xyz == vec3(-500, -140, -400))
+            break;
+    }
+
+    inter.Ka = material.Ka;
+    inter.Kd = material.Kd;
+    inter.Ks = material.Ks;
+    inter.Ke = material.Ke;
+    inter.isLight = resIsLight;
+    inter.bsdf = BSDF_LAMBERTIAN;
+    inter.material = resKey;
+
+	return inter;
+}
+
+// Triangle Process------------------------------------------------------------
+float GetTriangleArea(Triangle triangle)
+{
+    return length(cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0)) * 0.5;
+}
+
+Intersection SampleTriangleLight(Triangle triangle)
+{
+    Intersection inter;
+    float x = sqrt(GetRandFloat());
+    float y = GetRandFloat();
+
+    inter.coords = triangle.v0 * (1.0f - x) + triangle.v1 * (x * (1.0f - y)) + triangle.v2 * (x * y);
+    inter.normal = normalize(cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0));
+    return inter;
+}
+
+float GetLightArea()
+{
+    float emitAreaSum = 0;
+
+    Triangle triangle;
+    bool isLight = false;
+
+    vec3 res;
+    vec3 data[9];
+    int dataCounter = 0;
+
+    for (int counter = 0; counter < triTexSize; counter++)
+    {
+        res = Texture(TriData, counter, triTexSizeVec);
+
+        if (res.x == -10086)
+        {
+            isLight = res.z == 1.0 ? true : false;
+            continue;
+        }
+        if (res.x == -10087)
+        {
+            continue;
+        }
+        if (res.xyz == vec3(-500, -140, -400))
+            break;
+
+        if (isLight)
+        {
+            data[dataCounter++] = res.xyz;
+
+            if (dataCounter == 9)
+            {
+                dataCounter = 0;
+                triangle = Triangle(data[0], data[1], data[2],
+                                    data[3], data[4], data[5],
+                                    data[6], data[7], data[8]);
+                emitAreaSum += GetTriangleArea(triangle);
+            }
+        }
+    }
+
+    return emitAreaSum;
+}
+
+Intersection SampleLight()
+{
+    Intersection inter;
+    float emitAreaSum = 0;
+
+    Triangle triangle;
+    bool isLight = false;
+    bool isSampled = false;
+
+    vec3 res;
+    vec3 data[9];
+    int dataCounter = 0;
+
+    float p = GetRandFloat() * lightArea;
+
+    for (int counter = 0; counter < triTexSize; counter++)
+    {
+        res = Texture(TriData, counter, triTexSizeVec);
+
+        if (res.x == -10086)
+        {
+            isLight = res.z == 1.0 ? true : false;
+            continue;
+        }
+        if (res.x == -10087)
+        {
+            continue;
+        }
+        if (res.xyz == vec3(-500, -140, -400))
+            break;
+
+        if (isLight)
+        {
+            data[dataCounter++] = res.xyz;
+
+            if (dataCounter == 9)
+            {
+                dataCounter = 0;
+                triangle = Triangle(data[0], data[1], data[2],
+                                    data[3], data[4], data[5],
+                                    data[6], data[7], data[8]);
+                emitAreaSum += GetTriangleArea(triangle);
+                if (p <= emitAreaSum)
+                {
+                    inter = SampleTriangleLight(triangle);
+                    isSampled = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // lightArea comes from the CPU, rounding can leave p above the sum here: triangle is the last light then.
+    if (!isSampled && emitAreaSum > 0)
+        inter = SampleTriangleLight(triangle);
+
+    return inter;
+}
\ No newline at end of file
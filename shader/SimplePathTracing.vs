@@ -1,24 +1,10 @@
 #version 330 core
-#define LEFT_HAND_COORDS
-layout (location = 0) in vec3 rDir;
-layout (location = 1) in vec2 wCoord;
-
-out vec3 rayDirection;
-out vec3 eye;
-out vec2 screen;
-
-uniform vec2 Screen;
-uniform vec3 Eye;
 
+// Fullscreen triangle, no vertex buffer needed: (-1, -1), (3, -1), (-1, 3).
+// Rays are generated per fragment from gl_FragCoord, see GenerateRay() in SimplePathTracing.fs.
 void main()
 {
-    rayDirection = rDir;
-    eye = Eye;
-	screen = Screen;
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
 
-#ifdef LEFT_HAND_COORDS
-    gl_Position = vec4(-wCoord.x, wCoord.y, 0.0f, 1.0); // Left-Hand Coordinate
-#else
-    gl_Position = vec4(wCoord.x, wCoord.y, 0.0f, 1.0);
-#endif
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
 }
\ No newline at end of file
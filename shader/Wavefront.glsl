@@ -0,0 +1,83 @@
+// Wavefront backend: path state, queues and counters shared by the Wavefront*.cs stages.
+// Every path is identified by its pixel index, a path only lives in one queue at a time.
+// Include after PathTracingCommon.glsl.
+#define WAVEFRONT_GROUP_SIZE 64                // Keep in sync with Global::WavefrontGroupSize
+
+struct PathState
+{
+    vec4 origin;                               // xyz: Ray origin
+    vec4 direction;                            // xyz: Ray direction, w: Solid angle PDF of the BSDF sample that spawned the ray
+    vec4 throughput;                           // xyz: Path throughput
+    uint sampleIndex;                          // Random key: sample index
+    uint dimension;                            // Random key: next dimension
+    uint depth;                                // Number of bounces so far
+    uint padding;
+};
+
+struct HitRecord
+{
+    vec4 coords;                               // xyz: Hit point, w: Distance
+    vec4 normal;                               // xyz: Normal, w: 1 if happened
+    vec4 Ka;                                   // w: 1 if light
+    vec4 Kd;                                   // w: BSDF_*
+    vec4 Ks;                                   // w: Material key
+    vec4 Ke;
+};
+
+struct ShadowRay
+{
+    vec4 origin;                               // xyz: Shading point
+    vec4 target;                               // xyz: Point on the light
+    vec4 contribution;                         // xyz: MIS weighted radiance added if the light is visible, w: 1 if direct lighting
+    uint pixel;
+    uint padding[3];
+};
+
+layout (std430, binding = 0) buffer PathBuffer     { PathState Paths[];      };
+layout (std430, binding = 1) buffer HitBuffer      { HitRecord Hits[];       };
+layout (std430, binding = 2) buffer InQueueBuffer  { uint      InQueue[];    };
+layout (std430, binding = 3) buffer OutQueueBuffer { uint      OutQueue[];   };
+layout (std430, binding = 4) buffer ShadowBuffer   { ShadowRay ShadowRays[]; };
+layout (std430, binding = 5) buffer RadianceBuffer { vec4      Radiance[];   }; // xyz: Radiance of this frame, w: Sum of squared luminance of its finished samples
+layout (std430, binding = 7) buffer SampleStartBuffer { vec4   SampleStart[]; }; // xyz: Radiance before the current sample
+layout (std430, binding = 8) buffer DirectBuffer   { vec4      Direct[];     }; // xyz: Direct lighting part of Radiance, see the AOVs
+
+// Also bound as GL_DISPATCH_INDIRECT_BUFFER: the first three words are the work group count of the current queue.
+layout (std430, binding = 6) buffer CounterBuffer
+{
+    uint DispatchX;
+    uint DispatchY;
+    uint DispatchZ;
+    uint InCount;                              // Paths in InQueue
+    uint OutCount;                             // Paths pushed to OutQueue, atomicAdd
+    uint ShadowCount;                          // Shadow rays pushed to ShadowRays, atomicAdd
+    uint RayCount;                             // Extension and shadow rays traced since the host reset it
+};
+
+Intersection UnpackHit(HitRecord hit)
+{
+    Intersection inter;
+    inter.happened = hit.normal.w > 0.5f;
+    inter.isLight  = hit.Ka.w > 0.5f;
+    inter.coords   = hit.coords.xyz;
+    inter.normal   = hit.normal.xyz;
+    inter.Ka       = hit.Ka.xyz;
+    inter.Kd       = hit.Kd.xyz;
+    inter.Ks       = hit.Ks.xyz;
+    inter.Ke       = hit.Ke.xyz;
+    inter.distance = hit.coords.w;
+    inter.bsdf     = int(hit.Kd.w);
+    inter.material = hit.Ks.w;
+
+    return inter;
+}
+
+HitRecord PackHit(Intersection inter)
+{
+    return HitRecord(vec4(inter.coords, inter.distance),
+                     vec4(inter.normal, inter.happened ? 1.0f : 0.0f),
+                     vec4(inter.Ka, inter.isLight ? 1.0f : 0.0f),
+                     vec4(inter.Kd, float(inter.bsdf)),
+                     vec4(inter.Ks, inter.material),
+                     vec4(inter.Ke, 0.0f));
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 430 core
+
+// Wavefront stage 5: previous accumulation + radiance of this frame into the other accumulation and moment textures.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (rgba32f, binding = 0) uniform writeonly image2D Target; // AccumulationBuffer::BindImage()
+layout (r32f, binding = 1) uniform writeonly image2D MomentTarget; // AccumulationBuffer::BindMomentImage()
+layout (rgba32f, binding = 4) uniform writeonly image2D DirectTarget; // AccumulationBuffer::BindDirectImage()
+
+uniform sampler2D Accumulation;                // Accumulation of previous frames
+uniform sampler2D Moments;
+uniform int       AccumulatedSamples;          // Samples in Accumulation, 0 restarts accumulation
+uniform sampler2D DirectAccumulation;          // Direct of the pass in Accumulation
+uniform bool      RenderAOVs;                  // DirectTarget is bound
+
+void main()
+{
+    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);
+    if (pixelCoords.x >= int(Screen.x) || pixelCoords.y >= int(Screen.y))
+        return;
+
+    uint pixel = uint(pixelCoords.y) * uint(Screen.x) + uint(pixelCoords.x);
+
+    vec4 previous = vec4(0.0f);
+    float previousMoment = 0.0f;
+    vec4 previousDirect = vec4(0.0f);
+
+    if (AccumulatedSamples > 0)
+    {
+        previous = texelFetch(Accumulation, pixelCoords, 0);
+        previousMoment = texelFetch(Moments, pixelCoords, 0).r;
+        previousDirect = texelFetch(DirectAccumulation, pixelCoords, 0);
+
+        // same test as WavefrontGenerate.cs, which traced nothing for this pixel.
+        if (IsConverged(previous, previousMoment))
+        {
+            imageStore(Target, pixelCoords, previous);
+            imageStore(MomentTarget, pixelCoords, vec4(previousMoment));
+            if (RenderAOVs)
+                imageStore(DirectTarget, pixelCoords, previousDirect);
+            return;
+        }
+    }
+
+    // the last sample of the pass ends here.
+    float luminance = Luminance(Radiance[pixel].xyz - SampleStart[pixel].xyz);
+    float moment = Radiance[pixel].w + luminance * luminance;
+
+    imageStore(Target, pixelCoords, previous + vec4(Radiance[pixel].xyz, spp));
+    imageStore(MomentTarget, pixelCoords, vec4(previousMoment + moment));
+    if (RenderAOVs)
+        imageStore(DirectTarget, pixelCoords, previousDirect + vec4(Direct[pixel].xyz, spp));
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 430 core
+
+// Wavefront stage 4: visibility of the light samples pushed by WavefrontShade.cs.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+void main()
+{
+    if (gl_GlobalInvocationID.x >= ShadowCount)
+        return;
+
+    InitScene();
+
+    ShadowRay shadow = ShadowRays[gl_GlobalInvocationID.x];
+
+    vec3 p = shadow.origin.xyz;
+    vec3 x = shadow.target.xyz;
+
+    bool block = length(IntersectScene(Ray(p, normalize(x - p))).coords - x) > EPSILON;
+
+    if (!block)
+    {
+        Radiance[shadow.pixel].xyz += shadow.contribution.xyz;
+        if (shadow.contribution.w > 0.5f)
+            Direct[shadow.pixel].xyz += shadow.contribution.xyz;
+    }
+}
\ No newline at end of file
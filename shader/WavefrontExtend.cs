@@ -0,0 +1,20 @@
+#version 430 core
+
+// Wavefront stage 2: closest hit of every queued path.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+void main()
+{
+    if (gl_GlobalInvocationID.x >= InCount)
+        return;
+
+    InitScene();
+
+    uint path = InQueue[gl_GlobalInvocationID.x];
+    PathState state = Paths[path];
+
+    Hits[path] = PackHit(IntersectScene(Ray(state.origin.xyz, state.direction.xyz)));
+}
\ No newline at end of file
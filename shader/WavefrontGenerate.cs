@@ -0,0 +1,51 @@
+#version 430 core
+
+// Wavefront stage 0: one camera path per pixel, pushed to OutQueue.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+uniform int SampleOffset;                      // Sample of this pass, 0 ~ spp - 1
+
+uniform sampler2D Accumulation;                // Accumulation of previous frames
+uniform sampler2D Moments;
+uniform int       AccumulatedSamples;          // Samples in Accumulation, 0 restarts accumulation
+
+// Squared luminance of the sample that ended with the last Connect, its radiance is Radiance - SampleStart.
+void FinishSample(uint pixel)
+{
+    float luminance = Luminance(Radiance[pixel].xyz - SampleStart[pixel].xyz);
+    Radiance[pixel].w += luminance * luminance;
+}
+
+void main()
+{
+    uvec2 pixelCoords = gl_GlobalInvocationID.xy;
+    if (pixelCoords.x >= uint(Screen.x) || pixelCoords.y >= uint(Screen.y))
+        return;
+
+    uint pixel = pixelCoords.y * uint(Screen.x) + pixelCoords.x;
+
+    // converged pixels get no path, WavefrontAccumulate.cs carries their accumulation over.
+    if (AccumulatedSamples > 0 && IsConverged(texelFetch(Accumulation, ivec2(pixelCoords), 0),
+                                              texelFetch(Moments, ivec2(pixelCoords), 0).r))
+        return;
+
+    if (SampleOffset == 0)
+    {
+        Radiance[pixel] = vec4(0.0f);
+        Direct[pixel] = vec4(0.0f);
+    }
+    else
+        FinishSample(pixel);
+
+    SampleStart[pixel] = Radiance[pixel];
+
+    vec4 rayDir = RayRotateMatrix * vec4(GenerateRay(vec2(pixelCoords) + 0.5f), 0.0f);
+
+    Paths[pixel] = PathState(vec4(Eye.xyz, 0.0f), vec4(rayDir.xyz, 0.0f), vec4(1.0f),
+                             uint(FirstSample + SampleOffset), 0u, 0u, 0u);
+
+    OutQueue[atomicAdd(OutCount, 1u)] = pixel;
+}
\ No newline at end of file
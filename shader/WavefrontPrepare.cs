@@ -0,0 +1,21 @@
+#version 430 core
+
+// Wavefront stage 1: the paths pushed by the previous stage become the input queue.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = 1) in;
+
+void main()
+{
+    // the queue about to be extended plus the shadow rays of the last bounce.
+    RayCount += OutCount + ShadowCount;
+
+    InCount = OutCount;
+    OutCount = 0u;
+    ShadowCount = 0u;
+
+    DispatchX = (InCount + uint(WAVEFRONT_GROUP_SIZE) - 1u) / uint(WAVEFRONT_GROUP_SIZE);
+    DispatchY = 1u;
+    DispatchZ = 1u;
+}
\ No newline at end of file
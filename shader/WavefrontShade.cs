@@ -0,0 +1,123 @@
+#version 430 core
+
+// Wavefront stage 3: emission, next-event estimation and BSDF sampling at every hit.
+// Light samples go to ShadowRays, surviving paths go to OutQueue. Same estimator as Shade() in SimplePathTracing.fs.
+#include "PathTracingCommon.glsl"
+#include "Wavefront.glsl"
+
+layout (local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+layout (rgba32f, binding = 2) uniform writeonly image2D AlbedoTarget; // AccumulationBuffer::BindFeatureImages()
+layout (rgba32f, binding = 3) uniform writeonly image2D NormalTarget;
+
+void main()
+{
+    if (gl_GlobalInvocationID.x >= InCount)
+        return;
+
+    InitScene();
+    InitLights();
+
+    uint path = InQueue[gl_GlobalInvocationID.x];
+    PathState state = Paths[path];
+    Intersection inter = UnpackHit(Hits[path]);
+
+    rdPixel = path;
+    rdSample = state.sampleIndex;
+    rdDimension = state.dimension;
+
+    vec3 throughput = state.throughput.xyz;
+
+    // camera hit: the Denoiser's features, the same for every sample of the pixel.
+    if (state.depth == 0u)
+    {
+        vec4 albedo;
+        vec4 normal;
+        FirstHitFeatures(Ray(state.origin.xyz, state.direction.xyz), inter, albedo, normal);
+
+        ivec2 pixelCoords = ivec2(path % uint(Screen.x), path / uint(Screen.x));
+        imageStore(AlbedoTarget, pixelCoords, albedo);
+        imageStore(NormalTarget, pixelCoords, normal);
+    }
+
+    // Special case: camera ray outside the scene or on a light.
+    if (!inter.happened)
+    {
+        if (state.depth == 0u)
+        {
+            Radiance[path].xyz += vec3(0.2, 0.2, 0.2);
+            Direct[path].xyz += vec3(0.2, 0.2, 0.2);
+        }
+        return;
+    }
+
+    if (inter.isLight)
+    {
+        if (state.depth == 0u)
+        {
+            Radiance[path].xyz += lightColor;
+            Direct[path].xyz += lightColor;
+            return;
+        }
+
+        // BSDF sample hit the light: its emission, weighted against the light strategy, ends the path.
+        float cosHit = dot(-state.direction.xyz, normalize(inter.normal));
+        float lightPdf = cosHit > 0.0f ? pdfLight * inter.distance * inter.distance / cosHit : 0.0f;
+
+        vec3 contribution = throughput * PowerHeuristic(state.direction.w, lightPdf) * emit;
+
+        Radiance[path].xyz += contribution;
+        if (state.depth == 1u)
+            Direct[path].xyz += contribution;
+        return;
+    }
+
+    if (state.depth >= uint(MaxDepth))
+        return;
+
+    vec3 p = inter.coords;
+    vec3 N = normalize(inter.normal);
+    vec3 wo = normalize(-state.direction.xyz);
+
+    // Next-event estimation: visibility is resolved by WavefrontConnect.cs.
+    Intersection interLight = SampleLight();
+
+    vec3 x = interLight.coords;
+    vec3 ws = normalize(x - p);
+    vec3 NN = normalize(interLight.normal);
+    float cosLight = dot(-ws, NN);
+
+    if (cosLight > 0.0f)
+    {
+        float distance2 = dot(x - p, x - p);
+        float lightPdf = pdfLight * distance2 / cosLight;   // area measure to solid angle
+        float weight = PowerHeuristic(lightPdf, PDFBSDF(inter, wo, ws, N));
+        vec3 contribution = throughput * weight * emit * EvalBSDF(inter, wo, ws, N) * max(dot(ws, N), 0.0f) / lightPdf;
+
+        float direct = state.depth == 0u ? 1.0f : 0.0f;
+        ShadowRays[atomicAdd(ShadowCount, 1u)] = ShadowRay(vec4(p, 0.0f), vec4(x, 0.0f), vec4(contribution, direct),
+                                                           path, uint[3](0u, 0u, 0u));
+    }
+
+    // Russian Roulette test, survival probability follows the throughput.
+    if (state.depth >= uint(RussianRouletteDepth))
+    {
+        float survive = clamp(Luminance(throughput), 0.05f, 1.0f);
+        if (GetRandFloat() >= survive)
+            return;
+        throughput /= survive;
+    }
+
+    vec3 wi = normalize(SampleBSDF(inter, wo, N));
+    float bsdfPdf = PDFBSDF(inter, wo, wi, N);
+
+    if (bsdfPdf <= 0.0f)
+        return;
+
+    throughput *= IndirLightContriRate * EvalBSDF(inter, wo, wi, N) * dot(wi, N) / bsdfPdf;
+
+    Paths[path] = PathState(vec4(p, 0.0f), vec4(wi, bsdfPdf), vec4(throughput, 0.0f),
+                            state.sampleIndex, rdDimension, state.depth + 1u, 0u);
+
+    OutQueue[atomicAdd(OutCount, 1u)] = path;
+}
\ No newline at end of file
@@ -1,30 +1,64 @@
 #include "Utility.hpp"
 #include "CornellBox.hpp"
 
-// #include <chrono>
-#include <cstdlib>
-#include <ctime>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using Global::WindowWidth;
 using Global::WindowHeight;
 using Global::ImageName;
 using Global::ImageFileType;
 using Global::spp;
-using Global::RussianRoulette;
+using Global::MaxDepth;
+using Global::RussianRouletteDepth;
 using Global::IndirLightContributionRate;
 
-int main()
+int main(int argc, char **argv)
 {
-	GLFWwindow *window = Utility::SetupGlfwAndGlad();
+	Options options(argc, argv);
 
-	if (window == nullptr)
-		return 0;
+	if (!options.valid)
+		return 1;
+
+	// headless runs render into FBOs only, see HeadlessContext.
+	GLFWwindow *window = nullptr;
+	GLFWwindow *renderContext = nullptr;
+	HeadlessContext headless;
+	bool isThreaded = false;
+
+	if (options.headless)
+	{
+		if (!headless.Create(Global::Backend == Global::WAVEFRONT ? 4 : 3, 3))
+			return 1;
+	}
+	else
+	{
+		window = Utility::SetupGlfwAndGlad();
+
+		if (window == nullptr)
+			return 0;
 
-	Shader pathTracingShader("SimplePathTracing.vs", "SimplePathTracing.fs");
+		// the render thread owns a second context sharing window's objects, everything below is created on it.
+		if (Global::ThreadedRendering)
+			renderContext = Utility::CreateSharedContext(window);
+
+		isThreaded = renderContext != nullptr;
+		if (isThreaded)
+			glfwMakeContextCurrent(renderContext);
+	}
 
 	Camera &camera = Utility::camera;
-	camera.GenerateRay();
+	camera.GenerateUniformBlock();
+
+	// a tile worker gets the scene and the sample count from its coordinator instead of the model files.
+	TileWorker tileWorker;
+	bool isTileWorker = !options.worker.empty();
+	if (isTileWorker && !tileWorker.Connect(options.worker))
+		return 1;
 
 	Model floor(Global::ModelName, Global::FloorPath, true, Global::CornellMaterialPath);
 	Model left(Global::ModelName, Global::LeftPath, true, Global::CornellMaterialPath);
@@ -32,75 +66,626 @@ int main()
 	Model right(Global::ModelName, Global::RightPath, true, Global::CornellMaterialPath);
 	Model shortbox(Global::ModelName, Global::ShortboxPath, true, Global::CornellMaterialPath);
 	Model tallbox(Global::ModelName, Global::TallboxPath, true, Global::CornellMaterialPath);
-    floor.Load();
-	left.Load();
-	light.Load();
-	right.Load();
-	shortbox.Load();
-	tallbox.Load();
-
-	floor.Link(left);
-	floor.Link(light);
-	floor.Link(right);
-	floor.Link(shortbox);
-	floor.Link(tallbox);
-
 	ModelData modelData(floor);
-	modelData.GenerateModelTexture();
-	modelData.GenerateMaterialTexture();
-
-	auto tuple = Utility::SetVAOVBO(camera.vertices);
-	unsigned int VAO = std::get<0>(tuple);
-	// unsigned int VBO = std::get<1>(tuple); // uncomment if necessary.
-
-	pathTracingShader.use();
-	pathTracingShader.setArray("DefaultMat", 12, const_cast<float *>(Global::DefaultMat));
-	pathTracingShader.setInt("TriData", 0);
-	pathTracingShader.setInt("MatData", 1);
-	pathTracingShader.setInt("spp", 1); // high spp **real time** rendering is not supported(cuz path-tracing is not a realtime rt algorithm and FPS is very low).
-	pathTracingShader.setVec2("Screen", WindowWidth, WindowHeight);
-	// pathTracingShader.setArray("Triangles", sizeof(triangleVertices), const_cast<float *>(triangleVertices));
-	pathTracingShader.setFloat("RussianRoulette", RussianRoulette);
-	pathTracingShader.setFloat("IndirLightContriRate", IndirLightContributionRate);
 
-	srand(time(NULL));
+	if (isTileWorker)
+	{
+		if (!tileWorker.ReceiveScene(modelData))
+			return 1;
+		options.samples = options.stratification = tileWorker.GetSamples();
+	}
+	else
+	{
+		floor.Load();
+		left.Load();
+		light.Load();
+		right.Load();
+		shortbox.Load();
+		tallbox.Load();
+
+		floor.Link(left);
+		floor.Link(light);
+		floor.Link(right);
+		floor.Link(shortbox);
+		floor.Link(tallbox);
+
+		modelData.GenerateModelTexture();
+		modelData.GenerateMaterialTexture();
+	}
 
-	glm::mat4 rayRotateMatrix = glm::identity<glm::mat4>();
+	// path tracing programs are specialized for this scene and configuration, see Global::SpecializeShaders.
+	// startup cost of all programs, cold (compiled) vs warm (loaded from shader/binary/).
+	auto shaderStart = std::chrono::steady_clock::now();
 
-	// render loop=================================================================================
-	while (!glfwWindowShouldClose(window))
+	ShaderCache shaderCache;
+	ShaderDefines defines = Utility::PathTracingDefines(modelData);
+
+	// the fragment backend counts its rays if the driver has atomic counters, only when the interactive profiler shows them:
+	// one atomic per intersection slows every render down.
+	RayCounter rayCounter;
+	bool isCountingRays = !options.headless && (Global::ShowHud || Global::ProfileToCsv);
+	if (Global::Backend == Global::FRAGMENT && isCountingRays)
 	{
-		Utility::ProcessTime();
-		Utility::ProcessInput(window);
+		rayCounter.Generate();
+		if (rayCounter.GenerateCounter())
+			defines["COUNT_RAYS"] = "1";
+	}
 
-		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	Shader &pathTracingShader = shaderCache.Get("SimplePathTracing.vs", "SimplePathTracing.fs", defines);
+	Shader &displayShader = shaderCache.Get("Display.vs", "Display.fs");
+	Shader &hudShader = shaderCache.Get("Display.vs", "Hud.fs");
+	Denoiser denoiser(shaderCache);
 
-		float seed[4] = {(float)rand() / RAND_MAX, (float)rand() / RAND_MAX,
-						 (float)rand() / RAND_MAX, (float)rand() / RAND_MAX};
+	BlueNoise blueNoise;
+	if (Global::Sampler == Global::BLUE_NOISE || Global::RunConvergenceBenchmark)
+		blueNoise.GenerateNoiseTexture();
 
-		rayRotateMatrix = camera.GetRotateMatrix();
+	AccumulationBuffer &accumulation = Utility::accumulation;
+	accumulation.GenerateBuffer(options.headless ? options.aovs : Global::RenderAOVs);
+	Utility::image.GeneratePixelBuffers();
+	denoiser.Generate();
 
-		pathTracingShader.use();
-		pathTracingShader.setArray("rdSeed", 4, seed);
-		pathTracingShader.setMat4("RayRotateMatrix", rayRotateMatrix);
-		pathTracingShader.setVec3("Eye", camera.Position.x, camera.Position.y, camera.Position.z);
+	// both passes draw a fullscreen triangle from gl_VertexID, the VAO only has to exist.
+	unsigned int VAO;
+	glGenVertexArrays(1, &VAO);
+
+	Utility::PathTracingShaderSetup(pathTracingShader);
+	// pathTracingShader.setArray("Triangles", sizeof(triangleVertices), const_cast<float *>(triangleVertices));
+
+	// compute shader backend, shares the scene textures and the accumulation with the fragment path.
+	std::unique_ptr<WavefrontPathTracer> wavefront;
+	if (Global::Backend == Global::WAVEFRONT)
+	{
+		wavefront.reset(new WavefrontPathTracer(shaderCache, defines));
+		wavefront->ForEachShader(Utility::PathTracingShaderSetup);
+	}
+
+	std::chrono::duration<double, std::milli> shaderTime = std::chrono::steady_clock::now() - shaderStart;
+	std::cout << "Shader programs ready in " << shaderTime.count() << " ms" << std::endl;
+
+	displayShader.use();
+	displayShader.setInt("Accumulation", 3);
+	displayShader.setInt("ToneMapping", Global::ToneMapping);
+	displayShader.setFloat("Exposure", Global::Exposure);
+	displayShader.setFloat("Gamma", Global::Gamma);
+	displayShader.setVec2("RenderScale", 1.0f, 1.0f);
+	displayShader.setBool("ShowSampleCount", Global::ShowSampleCount);
 
+	int sampleIndex = 0;   // first sample of the next pass, keeps the samples of all passes decorrelated
+
+	TileScheduler tiles;
+	tiles.Generate();
+
+	PresentBuffer present;
+	if (isThreaded)
+		present.Generate();
+
+	auto bindScene = [&]()
+	{
 		modelData.UseModelTexture();
 		modelData.UseMaterialTexture();
+		blueNoise.UseNoiseTexture();
+		accumulation.UseTexture();
+		accumulation.UseDepthTexture();
+		accumulation.UseMomentTexture();
+		accumulation.UseDirectTexture();
+	};
+
+	auto drawScene = [&]()
+	{
+		bindScene();
+		rayCounter.BindCounter();
 
 		glBindVertexArray(VAO);
-		glDrawArrays(GL_POINTS, 0, WindowWidth * WindowHeight);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	};
+
+	if (Global::RunConvergenceBenchmark)
+	{
+		camera.UpdateUniformBlock();
+
+		// the benchmark switches samplers at runtime, so its variant keeps SamplerType a uniform.
+		ShaderDefines benchmarkDefines = defines;
+		benchmarkDefines.erase("SAMPLER_TYPE");
+
+		Shader &benchmarkShader = shaderCache.Get("SimplePathTracing.vs", "SimplePathTracing.fs", benchmarkDefines);
+		Utility::PathTracingShaderSetup(benchmarkShader);
+
+		ConvergenceBenchmark benchmark(benchmarkShader);
+		benchmark.Run(drawScene);
+
+		// HeadlessContext releases itself, glfwTerminate() only ends a windowed run.
+		wavefront.reset();
+		if (!options.headless)
+			glfwTerminate();
+		return 0;
+	}
+
+	if (options.headless)
+	{
+		int stratification = options.stratification;
+		pathTracingShader.use();
+		pathTracingShader.setInt("SampleCount", stratification);
+		if (wavefront != nullptr)
+			wavefront->ForEachShader([&](Shader &shader) { shader.use(); shader.setInt("SampleCount", stratification); });
+
+		camera.UpdateUniformBlock();
+		glViewport(0, 0, WindowWidth, WindowHeight);
+
+		auto saveImage = [&]()
+		{
+			auto saveStart = std::chrono::steady_clock::now();
+
+			accumulation.BindReadBuffer();
+			Utility::image.RequestReadback(accumulation.GetSampleCount(), true);
+			Utility::image.SaveImage(options.output.c_str(), options.outputType);
+
+			std::chrono::duration<double, std::milli> saveTime = std::chrono::steady_clock::now() - saveStart;
+			return saveTime.count();
+		};
+
+		if (isTileWorker)
+		{
+			// every tile restarts the accumulation and gets the passes of a local render, so its pixels match it.
+			auto renderTile = [&](const TileRect &tile, std::vector<float> &pixels)
+			{
+				accumulation.Reset();
+
+				glEnable(GL_SCISSOR_TEST);
+				glScissor(tile.x, tile.y, tile.width, tile.height);
+
+				for (int first = 0; first < options.samples; first += Global::BatchPassSamples)
+				{
+					int samples = std::min(Global::BatchPassSamples, options.samples - first);
+
+					accumulation.Bind();
+
+					pathTracingShader.use();
+					pathTracingShader.setInt("FirstSample", first);
+					pathTracingShader.setInt("spp", samples);
+					pathTracingShader.setInt("AccumulatedSamples", accumulation.GetSampleCount());
+
+					drawScene();
+					accumulation.Swap(samples);
+				}
+
+				glDisable(GL_SCISSOR_TEST);
+
+				pixels.resize(4 * tile.width * tile.height);
+				accumulation.BindReadBuffer();
+				glReadPixels(tile.x, tile.y, tile.width, tile.height, GL_RGBA, GL_FLOAT, pixels.data());
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			};
+
+			int tileCount = tileWorker.Run(renderTile);
+			std::cout << "Rendered " << tileCount << " tiles for " << options.worker << "." << std::endl;
+
+			return 0;
+		}
+
+		if (options.coordinatorPort > 0)
+		{
+			TileCoordinator coordinator(options, modelData);
+			if (!coordinator.Run())
+				return 1;
+
+			// the assembled accumulation is saved like a local one.
+			accumulation.Restore(coordinator.GetPixels(), std::vector<float>(Global::PixelCount, 0.0f), options.samples);
+			double saveTime = saveImage();
+			std::cout << "Saved " << options.output << " in " << saveTime << " ms." << std::endl;
+
+			return 0;
+		}
+
+		if (!options.merge.empty())
+		{
+			PartialAccumulation merged;
+			for (const std::string &fileName : options.merge)
+			{
+				PartialAccumulation partial;
+				if (!partial.Read(fileName) || !merged.Merge(partial))
+					return 1;
+			}
+
+			merged.Restore(accumulation);
+			double saveTime = saveImage();
+			std::cout << "Merged " << options.merge.size() << " partials with " << merged.GetSampleCount() << " of "
+					  << merged.GetStratification() << " spp, saved " << options.output << " in " << saveTime << " ms." << std::endl;
+
+			if (!options.partial.empty())
+				merged.Write(options.partial);
+
+			return 0;
+		}
+
+		// fixed passes, the convergence of adaptive sampling is tested per pass and a checkpoint has to land on the
+		// same pass boundaries as an uninterrupted render. The tile budget still splits every pass into batches.
+		auto renderPass = [&](int maxSamples)
+		{
+			int samples = std::min(Global::BatchPassSamples, maxSamples);
+			bool isPassComplete = true;
+
+			if (wavefront != nullptr)
+			{
+				bindScene();
+				tiles.RenderWhole([&]() { wavefront->Render(sampleIndex, samples, accumulation); }, samples);
+			}
+			else
+			{
+				accumulation.Bind();
+
+				pathTracingShader.use();
+				pathTracingShader.setInt("FirstSample", sampleIndex);
+				pathTracingShader.setInt("spp", samples);
+				pathTracingShader.setInt("AccumulatedSamples", accumulation.GetSampleCount());
+
+				isPassComplete = tiles.Render(drawScene, samples);
+			}
+
+			if (!isPassComplete)
+				return 0;
+
+			accumulation.Swap(samples);
+			sampleIndex += samples;
+			return samples;
+		};
+
+		BatchRenderer batch(options, accumulation);
+		Checkpoint checkpoint(options.checkpoint);
+		sampleIndex = options.firstSample;
+
+		if (!options.resume.empty())
+		{
+			Checkpoint resumed(options.resume);
+			if (!resumed.Load(accumulation, sampleIndex, stratification, batch))
+				return 1;
+			std::cout << "Resumed " << options.resume << " at " << accumulation.GetSampleCount() << " spp." << std::endl;
+		}
+
+		if (options.checkpoint.empty())
+			batch.Run(renderPass);
+		else
+			batch.Run(renderPass, [&]() { checkpoint.Save(accumulation, sampleIndex, stratification, batch); });
+
+		double saveTime = saveImage();
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		batch.WriteStats(saveTime);
+		std::cout << "Saved " << options.output << " in " << saveTime << " ms, statistics in " << options.stats << "." << std::endl;
 
-		Utility::PostProcess();
+		if (!options.sampleMap.empty())
+			batch.WriteSampleMap();
+
+		if (options.aovs)
+		{
+			std::string baseName = options.output.substr(0, options.output.find_last_of('.'));
+			Utility::aovs.ReadBack(accumulation);
+			if (Utility::aovs.Write(baseName))
+				std::cout << "AOVs in " << baseName << "_<aov>.pfm." << std::endl;
+		}
+
+		if (!options.denoise.empty())
+		{
+			auto denoiseStart = std::chrono::steady_clock::now();
+
+			if (options.denoiseOnCpu)
+			{
+				std::vector<float> denoised;
+				denoiser.RunCpu(accumulation, denoised);
+				Utility::image.SaveAccumulation(denoised);
+			}
+			else
+			{
+				denoiser.Run(accumulation);
+				denoiser.BindReadBuffer();
+				Utility::image.RequestReadback(accumulation.GetSampleCount(), true);
+				Utility::image.Flush();
+			}
+
+			std::chrono::duration<double, std::milli> denoiseTime = std::chrono::steady_clock::now() - denoiseStart;
+			Utility::image.SaveImage(options.denoise.c_str(), options.denoiseType);
+			std::cout << "Denoised on the " << (options.denoiseOnCpu ? "CPU" : "GPU") << " in " << denoiseTime.count()
+					  << " ms, saved " << options.denoise << "." << std::endl;
+		}
+
+		if (!options.partial.empty())
+		{
+			PartialAccumulation partial;
+			partial.ReadBack(accumulation, stratification, options.firstSample);
+			if (partial.Write(options.partial))
+				std::cout << "Partial accumulation of samples " << options.firstSample << " ~ " << sampleIndex - 1 << " in " << options.partial << "." << std::endl;
+		}
+
+		return 0;
+	}
+
+	Profiler profiler;
+	profiler.Generate();
+	profiler.GenerateTimer(GPU_PATH_TRACING);
+	if (!isThreaded)
+		profiler.GenerateTimer(GPU_DISPLAY);
+
+	DynamicResolution resolution;
+
+	// camera and resolution of the pass in the accumulation's latest texture: what the display upsamples
+	// and what reprojection maps from after a camera change.
+	glm::mat4 passRotate = camera.GetRotateMatrix();
+	glm::vec4 passEye(camera.Position, 1.0f);
+	glm::vec4 passScreen(WindowWidth, WindowHeight, Global::Scale, Global::ImageAspectRatio);
+
+	// camera of the frame being rendered, input may move Utility::camera meanwhile.
+	glm::mat4 frameRotate = passRotate;
+	glm::vec4 frameEye = passEye;
+
+	int renderWidth = WindowWidth;
+	int renderHeight = WindowHeight;
+	bool isReprojectionPending = false;
+
+	// the sample count view shows the accumulation's counts, which the denoised image doesn't have.
+	bool isDenoised = Global::Denoise && !Global::ShowSampleCount;
+
+	auto completePass = [&](int samples)
+	{
+		accumulation.Swap(samples);
+		sampleIndex += samples;
+
+		passRotate = frameRotate;
+		passEye = frameEye;
+		passScreen = glm::vec4(renderWidth, renderHeight, Global::Scale, Global::ImageAspectRatio);
+		isReprojectionPending = false;
+
+		if (isDenoised)
+			denoiser.Run(accumulation, renderWidth, renderHeight);
+
+		if (isThreaded)
+			present.Publish(accumulation, glm::vec2(passScreen.x / WindowWidth, passScreen.y / WindowHeight), isDenoised ? &denoiser : nullptr);
+	};
+
+	// path tracing of one frame, on the render thread if Global::ThreadedRendering.
+	// frameTime: seconds of the previous call.
+	auto renderFrame = [&](float frameTime)
+	{
+		if (Utility::ProcessSaveRequest())
+			tiles.Restart();
+
+		{
+			std::lock_guard<std::mutex> lock(Utility::cameraMutex);
+
+			bool cameraMoved = camera.ConsumeMoved();
+
+			// fast feedback while navigating, full resolution once the camera rests or while saving.
+			resolution.Update(cameraMoved, frameTime, Utility::IsSaving(), tiles.GetBudgetPixels());
+			bool isResized = resolution.GetWidth() != renderWidth || resolution.GetHeight() != renderHeight;
+			renderWidth = resolution.GetWidth();
+			renderHeight = resolution.GetHeight();
+
+			// samples accumulate while the view stays, another viewpoint or pixel grid starts over (or is reprojected),
+			// so neither the display nor FrameSaver mixes samples of different views.
+			if (cameraMoved || isResized)
+			{
+				if (Utility::IsSaving() && accumulation.GetSampleCount() > 0)
+					std::cout << "Camera moved while saving, accumulation restarts." << std::endl;
+
+				accumulation.Reset();
+				tiles.Restart();
+				isReprojectionPending = Global::TemporalReprojection && wavefront == nullptr;
+			}
+
+			profiler.BeginCpu(CPU_UPLOAD);
+			camera.UpdateUniformBlock(renderWidth, renderHeight);
+			profiler.EndCpu(CPU_UPLOAD);
+
+			frameRotate = camera.GetRotateMatrix();
+			frameEye = glm::vec4(camera.Position, 1.0f);
+		}
+
+		long long frameSamples = 0;
+		long long frameRays = -1;   // rays whose count arrived this frame, -1 if the backend can't count them
+
+		// samples per pixel of the pass that fill the time budget, but no more than Global::spp while saving.
+		int passSamples = tiles.GetPassSamples();
+		if (Utility::IsSaving())
+			passSamples = std::max(1, std::min(passSamples, spp - accumulation.GetSampleCount()));
+
+		// path tracing pass: previous accumulation + new samples into the other float texture.
+		// the scheduler times the pass itself, GL_TIME_ELAPSED queries can't nest.
+		if (wavefront != nullptr)
+		{
+			bindScene();
+
+			tiles.RenderWhole([&]() { wavefront->Render(sampleIndex, passSamples, accumulation); }, passSamples);
+			profiler.SetGpuTime(GPU_PATH_TRACING, tiles.GetGpuTime());
+
+			completePass(passSamples);
+			frameSamples = (long long)renderWidth * renderHeight * passSamples;
+			frameRays = wavefront->PollRayCount();
+		}
+		else
+		{
+			// a reduced pass is for fast feedback, one sample is enough.
+			int samples = resolution.IsReduced() ? 1 : passSamples;
+
+			accumulation.Bind(renderWidth, renderHeight);
+
+			pathTracingShader.use();
+			pathTracingShader.setInt("FirstSample", sampleIndex);
+			pathTracingShader.setInt("spp", samples);
+			pathTracingShader.setInt("AccumulatedSamples", accumulation.GetSampleCount());
+
+			// the first pass after a camera change starts from the last one, seen from its camera.
+			pathTracingShader.setBool("Reproject", isReprojectionPending && !Utility::IsSaving());
+			pathTracingShader.setMat4("PreviousRotateMatrix", passRotate);
+			pathTracingShader.setVec4("PreviousEye", passEye);
+			pathTracingShader.setVec4("PreviousScreen", passScreen);
+
+			if (resolution.IsReduced())
+			{
+				// a reduced pass is one draw sized by the frame time controller.
+				drawScene();
+
+				completePass(samples);
+				frameSamples = (long long)renderWidth * renderHeight;
+			}
+			else
+			{
+				// a pass may take several frames, the display keeps showing the last complete one meanwhile.
+				bool isPassComplete = tiles.Render(drawScene, samples);
+				profiler.SetGpuTime(GPU_PATH_TRACING, tiles.GetGpuTime());
+
+				if (isPassComplete)
+				{
+					completePass(samples);
+					frameSamples = (long long)Global::PixelCount * samples;
+				}
+			}
+
+			if (isCountingRays && rayCounter.IsCounting())
+			{
+				rayCounter.Snapshot();
+				frameRays = rayCounter.Poll();
+			}
+		}
+
+		profiler.BeginCpu(CPU_READBACK);
+		Utility::PostProcess(frameTime);
+		profiler.EndCpu(CPU_READBACK);
+
+		profiler.EndFrame(frameTime, frameSamples, frameRays, accumulation.GetSampleCount());
+	};
+
+	Hud hud(hudShader);
+
+	// display pass: tone mapped average of the accumulation bound to texture unit 3, then the HUD.
+	// renderScale: rendered part of the accumulation.
+	auto displayFrame = [&](unsigned int vertexArray, const glm::vec2 &renderScale, int sampleCount)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, Utility::framebufferWidth, Utility::framebufferHeight);
+
+		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		profiler.BeginGpu(GPU_DISPLAY);
+
+		displayShader.use();
+		displayShader.setVec2("RenderScale", renderScale.x, renderScale.y);
+		displayShader.setFloat("SampleCount", (float)sampleCount);
+
+		glBindVertexArray(vertexArray);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		profiler.EndGpu(GPU_DISPLAY);
+
+		// drawn into the window only, saved images come from the accumulation.
+		if (Global::ShowHud)
+		{
+			hud.Update(profiler);
+			hud.Draw(vertexArray, Utility::framebufferWidth, Utility::framebufferHeight);
+		}
+	};
+
+	if (isThreaded)
+	{
+		// render thread: passes as fast as the GPU takes them, each completed one is published to the presenter.
+		std::atomic<bool> isRendering(true);
+		glfwMakeContextCurrent(NULL);
+
+		std::thread renderThread([&]()
+		{
+			glfwMakeContextCurrent(renderContext);
+
+			auto lastFrame = std::chrono::steady_clock::now();
+			GLsync inFlight = 0;
+
+			while (isRendering)
+			{
+				auto currentFrame = std::chrono::steady_clock::now();
+				std::chrono::duration<float> frameTime = currentFrame - lastFrame;
+				lastFrame = currentFrame;
+
+				renderFrame(frameTime.count());
+
+				// at most one frame queued on the GPU, so a frame's camera is never older than the frame before.
+				GLsync frameDone = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				if (inFlight != 0)
+				{
+					glClientWaitSync(inFlight, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+					glDeleteSync(inFlight);
+				}
+				inFlight = frameDone;
+			}
+
+			if (inFlight != 0)
+				glDeleteSync(inFlight);
+
+			glFinish();
+			glfwMakeContextCurrent(NULL);
+		});
+
+		// presenter: input and the latest published pass at vsync, however long a pass takes.
+		glfwMakeContextCurrent(window);
+		glfwSwapInterval(1);
+
+		// vertex array objects aren't shared between contexts.
+		unsigned int presentVAO;
+		glGenVertexArrays(1, &presentVAO);
+		profiler.GenerateTimer(GPU_DISPLAY);
+
+		// present loop==============================================================================
+		while (!glfwWindowShouldClose(window))
+		{
+			Utility::ProcessTime();
+
+			profiler.BeginCpu(CPU_INPUT);
+			Utility::ProcessInput(window);
+			profiler.EndCpu(CPU_INPUT);
+
+			glm::vec2 presentScale = present.Acquire();
+			displayFrame(presentVAO, presentScale, present.GetSampleCount());
+			present.Release();
+
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		//=============================================================================================
+
+		isRendering = false;
+		renderThread.join();
+
+		glDeleteVertexArrays(1, &presentVAO);
+
+		// the readbacks and their fences belong to the render context.
+		glfwMakeContextCurrent(renderContext);
+	}
+	else
+	{
+		// render loop=================================================================================
+		while (!glfwWindowShouldClose(window))
+		{
+			Utility::ProcessTime();
+
+			profiler.BeginCpu(CPU_INPUT);
+			Utility::ProcessInput(window);
+			profiler.EndCpu(CPU_INPUT);
+
+			renderFrame(Utility::deltaTime);
+
+			if (isDenoised)
+				denoiser.UseTexture();
+			else
+				accumulation.UseTexture();
+			displayFrame(VAO, glm::vec2(passScreen.x / WindowWidth, passScreen.y / WindowHeight), accumulation.GetSampleCount());
+
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		//=============================================================================================
 	}
-	//=============================================================================================
 
 	Utility::image.SaveImage(ImageName.c_str(), ImageFileType);
 
+	// its buffers go while the context is alive.
+	wavefront.reset();
+
 	glfwTerminate();
 	return 0;
 }
\ No newline at end of file